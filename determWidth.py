@@ -14,13 +14,33 @@ def main():
     parser.add_argument('--p', help='check if the deterministic width is < (smaller) or >= (greater equal) than p', type=int)
     parser.add_argument('--exact',  help='find the exact deterministic width (def. False)',action='store_true')
     parser.add_argument('--memory',  help='minimize memory footprint (def. False)',action='store_true')
+    parser.add_argument('--lazy',  help='explore the A^p automaton on the fly, stopping at the first cycle (def. False)',action='store_true')
+    parser.add_argument('--threads',  help='number of threads building the A^p automaton (def. 1)',type=int, default=1)
     parser.add_argument('--keep',  help='keep intermediate files (def. False, debug only)',action='store_true')
-    #parser.add_argument('--stats',  help='print stats to file (def. False)',type=str, default="empty")
+    parser.add_argument('--cache',  help='directory of the result cache, keyed by the minimum DFA (def. no cache)',type=str)
+    parser.add_argument('--batch',  help='the input is a manifest of queries, answered by build/det-width-batch.x in one process (def. False)',action='store_true')
+    parser.add_argument('--legacy',  help='run the multi-process pipeline through intermediate files (def. False)',action='store_true')
+    parser.add_argument('--stats',  help='write the time, peak memory and counters of every phase to file (JSON, def. no file)',type=str)
     parser.add_argument('--verbose',  help='activate verbose mode (def. False)',action='store_true')
     args = parser.parse_args()
     # Wheeler option has been activated
     if args.Wheeler:
         args.p = 2
+    # batch mode: the options are the defaults of the manifest queries
+    if args.batch:
+        batch_exe = os.path.join(os.path.split(sys.argv[0])[0], "build/det-width-batch.x")
+        command = [batch_exe, "-j", str(args.threads)]
+        if args.cache:
+            command += ["-c", args.cache]
+        if args.memory:
+            command.append("-m")
+        if args.lazy:
+            command.append("-l")
+        if args.exact:
+            command.append("-e")
+        elif args.p is not None:
+            command += ["-p", str(args.p)]
+        exit(subprocess.call(command + [args.input]))
     # check selected width
     if((not args.exact) and (args.p < 2)):
         print("The width to check must be >= 2.")
@@ -44,6 +64,7 @@ def main():
     reg_to_dfa_exe =  os.path.join(args.main_dir, "external/RegexpToAutomaton/regToAutomaton")
     det_width_exe = os.path.join(args.main_dir, "build/det-width.x")
     det_width_mem_exe = os.path.join(args.main_dir, "build/det-width-rm.x")
+    pipeline_exe = os.path.join(args.main_dir, "build/det-width-pipe.x")
 
     if args.memory:
         det_width_exe = det_width_mem_exe
@@ -71,209 +92,218 @@ def main():
 
         ############################################
 
-        if( args.DFA ):
+        if not args.legacy:
 
             start = time.time()
 
-            # compute the minimum dfa        
-            command = "{exe} -in < {input} > {output}".format(exe=dfamin_exe, input=args.input, output=args.input+".min")
-            if args.verbose:
-                print("==== computing minimum DFA. Command: ", command)
-
-            with open(args.input, 'rb', 0) as a, open(args.input+".min", 'w') as b:
-                rc = subprocess.call(dfamin_exe, stdin=a, stdout=b)
-
-            if args.verbose:
-                print("Elapsed time: {0:.4f}".format(time.time()-start))
-            args.input = args.input+".min"
+            if not args.exact:
 
-        ############################################
-
-        start = time.time()
-
-        command = "{exe} {input} {mindfa} {maxdfa}".format(exe=pruning_exe, input=args.input, mindfa=args.input+".prmin", maxdfa=args.input+".prmax")
+                if args.verbose:
+                    print("==== compute minimum DFA, intervals and A^p pruned automaton in a single process")
+                answer = pipeline_answer(args, args.p, pipeline_exe, logfile, logfile_name)
+                if answer is None:
+                    return
 
-        if args.verbose:
-            print("==== pruning minimum DFA. Command: ", command)
-        if(execute_command(command,logfile,logfile_name)!=True):
-            return
-        if args.verbose:
-            print("Elapsed time: {0:.4f}".format(time.time()-start))
+                if args.verbose:
+                    print("Elapsed time: {0:.4f}".format(time.time()-start))
 
-        ############################################
+                print("#########")
+                if args.Wheeler:
+                    if(answer == "1"):
+                        print('\033[95m' + "    The regular language is Wheeler")
+                    else:
+                        print('\033[95m' + "    The regular language is NOT Wheeler")
+                else:
+                    if(answer == "1"):
+                        print('\033[95m' + "    The deterministic width is <(smaller than)",args.p)
+                    else:
+                        print('\033[95m' + "    The deterministic width is  >=(greater or equal than)",args.p)
+                print('\033[0m' + "#########")
 
-        start = time.time()
+            else:
 
-        no_nodes = 0
-        source = 0
-        with open(args.input+".prmin", "rb") as file:
-            try:
-                file.seek(-2, os.SEEK_END)
-                while file.read(1) != b'\n':
-                    file.seek(-2, os.SEEK_CUR) 
-            except OSError:
-                file.seek(0)
-            last_line = file.readline().decode()
-            no_nodes = int(last_line.split(" ")[0])
-            source = int(last_line.split(" ")[2])
+                if args.verbose:
+                    print("==== compute the exact width in a single process")
+                low = pipeline_answer(args, 0, pipeline_exe, logfile, logfile_name)
+                if low is None:
+                    return
 
-        command = "{exe} {input} {output} {nodes} {source} 0 1 0 1 0 1".format(exe=partref_exe, input=args.input+".prmin", output=args.input+".infima", nodes=no_nodes, source=source)
+                if args.verbose:
+                    print("Elapsed time: {0:.4f}".format(time.time()-start))
 
-        if args.verbose:
-            print("==== compute infima strings DFA. Command: ", command)
-        if(execute_command(command,logfile,logfile_name)!=True):
-            return
+                print("#########")
+                print("    Regular language deterministic width:",'\033[95m' + "p =",low)
+                print('\033[0m' + "#########")
 
-        command = "{exe} {input} {output} {nodes} {source} 0 1 1 1 0 1".format(exe=partref_exe, input=args.input+".prmax", output=args.input+".suprema", nodes=no_nodes, source=source)
+        else:
 
-        if args.verbose:
-            print("==== compute suprema strings DFA. Command: ", command)
-        if(execute_command(command,logfile,logfile_name)!=True):
-            return
+            if( args.DFA ):
 
-        if args.verbose:
-            print("Elapsed time: {0:.4f}".format(time.time()-start))
+                start = time.time()
 
-        ############################################
+                # compute the minimum dfa        
+                command = "{exe} -in < {input} > {output}".format(exe=dfamin_exe, input=args.input, output=args.input+".min")
+                if args.verbose:
+                    print("==== computing minimum DFA. Command: ", command)
 
-        start = time.time()
+                with open(args.input, 'rb', 0) as a, open(args.input+".min", 'w') as b:
+                    rc = subprocess.call(dfamin_exe, stdin=a, stdout=b)
 
-        '''
-        command = "{exe} {input1} {input2}".format(exe=doublingmerge_exe, input1=args.input+".infima", input2=args.input+".suprema")
-        print("==== merging infima and suprema pruned DFAs. Command: ", command)
+                if args.verbose:
+                    print("Elapsed time: {0:.4f}".format(time.time()-start))
+                args.input = args.input+".min"
 
-        with open(args.input+".interval", 'w') as b:
-            rc = subprocess.call(command.split(), stdout=b)
-        '''
-        no_states = source = 0
-        with open(args.input,'r') as fp:
-            header = fp.readline().split()
-            no_states = header[0]
-            source = header[2]
+            ############################################
 
-        command = "{exe} {input1} {input2} {output} {states} {source_state} 0 1".format(exe=partrefmerge_exe, input1=args.input+".infima",
-                                                                                        input2=args.input+".suprema", output=args.input+".interval",
-                                                                                        states = no_states, source_state = source)
-        if args.verbose:
-            print("==== merging infimum and supremum pruned DFAs. Command: ", command)
-        if(execute_command(command,logfile,logfile_name)!=True):
-            return
+            start = time.time()
 
-        if args.verbose:
-            print("Elapsed time: {0:.4f}".format(time.time()-start))
+            command = "{exe} {input} {mindfa} {maxdfa}".format(exe=pruning_exe, input=args.input, mindfa=args.input+".prmin", maxdfa=args.input+".prmax")
 
-        ############################################
+            if args.verbose:
+                print("==== pruning minimum DFA. Command: ", command)
+            if(execute_command(command,logfile,logfile_name)!=True):
+                return
+            if args.verbose:
+                print("Elapsed time: {0:.4f}".format(time.time()-start))
 
-        start = time.time()
+            ############################################
 
-        if not args.exact:
+            start = time.time()
 
-            if args.Wheeler:
+            no_nodes = 0
+            source = 0
+            with open(args.input+".prmin", "rb") as file:
+                try:
+                    file.seek(-2, os.SEEK_END)
+                    while file.read(1) != b'\n':
+                        file.seek(-2, os.SEEK_CUR) 
+                except OSError:
+                    file.seek(0)
+                last_line = file.readline().decode()
+                no_nodes = int(last_line.split(" ")[0])
+                source = int(last_line.split(" ")[2])
+
+            command = "{exe} {input} {output} {nodes} {source} 0 1 0 1 0 1".format(exe=partref_exe, input=args.input+".prmin", output=args.input+".infima", nodes=no_nodes, source=source)
 
-                command = "{exe} {p} {dfa} {interval}".format(exe=det_width_exe, p=args.p, dfa=args.input, interval=args.input+".interval")
+            if args.verbose:
+                print("==== compute infima strings DFA. Command: ", command)
+            if(execute_command(command,logfile,logfile_name)!=True):
+                return
 
-                if args.verbose:
-                    print("==== compute A^2 pruned automaton and check language Wheelerness. Command: ", command)
-                if(execute_command(command,logfile,logfile_name)!=True):
-                    return
+            command = "{exe} {input} {output} {nodes} {source} 0 1 1 1 0 1".format(exe=partref_exe, input=args.input+".prmax", output=args.input+".suprema", nodes=no_nodes, source=source)
 
-                if args.verbose:
-                    print("Elapsed time: {0:.4f}".format(time.time()-start))
+            if args.verbose:
+                print("==== compute suprema strings DFA. Command: ", command)
+            if(execute_command(command,logfile,logfile_name)!=True):
+                return
 
-                with open("answer", 'rb', 0) as a:
-                    answer = a.readline().decode()
-                    if(answer == "1"):
-                        print("#########")
-                        print('\033[95m' + "    The regular language is Wheeler")
-                        print('\033[0m' + "#########")
-                    else:
-                        print("#########")
-                        print('\033[95m' + "    The regular language is NOT Wheeler")
-                        print('\033[0m' + "#########")
+            if args.verbose:
+                print("Elapsed time: {0:.4f}".format(time.time()-start))
 
-            else:
+            ############################################
 
-                command = "{exe} {p} {dfa} {interval}".format(exe=det_width_exe, p=args.p, dfa=args.input, interval=args.input+".interval")
+            start = time.time()
 
-                if args.verbose:
-                    print("==== compute A^p pruned automaton and check language width. Command: ", command)
-                if(execute_command(command,logfile,logfile_name)!=True):
-                    return
+            '''
+            command = "{exe} {input1} {input2}".format(exe=doublingmerge_exe, input1=args.input+".infima", input2=args.input+".suprema")
+            print("==== merging infima and suprema pruned DFAs. Command: ", command)
+
+            with open(args.input+".interval", 'w') as b:
+                rc = subprocess.call(command.split(), stdout=b)
+            '''
+            no_states = source = 0
+            with open(args.input,'r') as fp:
+                header = fp.readline().split()
+                no_states = header[0]
+                source = header[2]
+
+            command = "{exe} {input1} {input2} {output} {states} {source_state} 0 1".format(exe=partrefmerge_exe, input1=args.input+".infima",
+                                                                                            input2=args.input+".suprema", output=args.input+".interval",
+                                                                                            states = no_states, source_state = source)
+            if args.verbose:
+                print("==== merging infimum and supremum pruned DFAs. Command: ", command)
+            if(execute_command(command,logfile,logfile_name)!=True):
+                return
 
-                if args.verbose:
-                    print("Elapsed time: {0:.4f}".format(time.time()-start))
+            if args.verbose:
+                print("Elapsed time: {0:.4f}".format(time.time()-start))
 
-                with open("answer", 'rb', 0) as a:
-                    answer = a.readline().decode()
-                    if(answer == "1"):
-                        print("#########")
-                        print('\033[95m' + "    The deterministic width is <(smaller than)",args.p)
-                        print('\033[0m' + "#########")
-                    else:
-                        print("#########")
-                        print('\033[95m' + "    The deterministic width is  >=(greater or equal than)",args.p)
-                        print('\033[0m' + "#########")
-        else:
+            ############################################
 
-            no_states = 0
-            with open(args.input+".interval",'r') as fp:
-                no_states = sum(1 for line in fp)
+            start = time.time()
 
-            language_width = 0
-            high = int(no_states)
-            low = 1
-            middle = 2
+            if not args.exact:
+
+                if args.Wheeler:
+
+                    command = "{exe} {p} {dfa} {interval}".format(exe=det_width_exe, p=args.p, dfa=args.input, interval=args.input+".interval")
+
+                    if args.verbose:
+                        print("==== compute A^2 pruned automaton and check language Wheelerness. Command: ", command)
+                    if(execute_command(command,logfile,logfile_name)!=True):
+                        return
+
+                    if args.verbose:
+                        print("Elapsed time: {0:.4f}".format(time.time()-start))
+
+                    with open("answer", 'rb', 0) as a:
+                        answer = a.readline().decode()
+                        if(answer == "1"):
+                            print("#########")
+                            print('\033[95m' + "    The regular language is Wheeler")
+                            print('\033[0m' + "#########")
+                        else:
+                            print("#########")
+                            print('\033[95m' + "    The regular language is NOT Wheeler")
+                            print('\033[0m' + "#########")
+
+                else:
+
+                    command = "{exe} {p} {dfa} {interval}".format(exe=det_width_exe, p=args.p, dfa=args.input, interval=args.input+".interval")
+
+                    if args.verbose:
+                        print("==== compute A^p pruned automaton and check language width. Command: ", command)
+                    if(execute_command(command,logfile,logfile_name)!=True):
+                        return
+
+                    if args.verbose:
+                        print("Elapsed time: {0:.4f}".format(time.time()-start))
+
+                    with open("answer", 'rb', 0) as a:
+                        answer = a.readline().decode()
+                        if(answer == "1"):
+                            print("#########")
+                            print('\033[95m' + "    The deterministic width is <(smaller than)",args.p)
+                            print('\033[0m' + "#########")
+                        else:
+                            print("#########")
+                            print('\033[95m' + "    The deterministic width is  >=(greater or equal than)",args.p)
+                            print('\033[0m' + "#########")
+            else:
 
-            while True:
+                # one process computes the exact width sharing the DFA, the intervals and L among probes
+                command = "{exe} -e {dfa} {interval}".format(exe=det_width_exe, dfa=args.input, interval=args.input+".interval")
 
-                command = "{exe} {p} {dfa} {interval}".format(exe=det_width_exe, p=middle, dfa=args.input, interval=args.input+".interval")
-                #print(command)
+                if args.verbose:
+                    print("==== compute the exact width. Command: ", command)
                 if(execute_command(command,logfile,logfile_name)!=True):
                     return
 
                 with open("answer", 'rb', 0) as a:
-                    answer = a.readline().decode()
-                    if(answer == "1"):
-                        high = middle - 1
-                        break
-                        #print("*** The width p of the language recognized by the input is <(smaller than)",args.width)
-                    else:
-                        low = middle
-                        #print("*** The width p of the language recognized by the input is >=(greater or equal than)",args.width)
-
-                middle *= 2
-                if middle > no_states:
-                    high = no_states
-                    break
-
-            #if args.verbose:
-            #    print("p is between:",low,"and",high)
-
-            while low != high:
-
-                middle = math.ceil((low+high)/2)
+                    low = a.readline().decode()
 
-                command = "{exe} {p} {dfa} {interval}".format(exe=det_width_exe, p=middle, dfa=args.input, interval=args.input+".interval")
-                #print(command)
-                if(execute_command(command,logfile,logfile_name)!=True):
-                    return
-
-                with open("answer", 'rb', 0) as a:
-                    answer = a.readline().decode()
-                    if(answer == "1"):
-                        high = middle - 1
-                    else:
-                        low = middle
+                if args.verbose:
+                    print("Elapsed time: {0:.4f}".format(time.time()-start))
 
-            print("#########")
-            print("    Regular language deterministic width:",'\033[95m' + "p =",low)
-            print('\033[0m' + "#########")
-            #language_width = low
+                print("#########")
+                print("    Regular language deterministic width:",'\033[95m' + "p =",low)
+                print('\033[0m' + "#########")
+                #language_width = low
 
-            #if args.stats != "empty":
-                # print stats
-            #    with open(os.path.join(args.main_dir,args.stats),"w+") as fp:
-            #        fp.write(str(language_width))
+                #if args.stats != "empty":
+                    # print stats
+                #    with open(os.path.join(args.main_dir,args.stats),"w+") as fp:
+                #        fp.write(str(language_width))
 
         ############################################
 
@@ -288,6 +318,28 @@ def main():
             os.remove(os.path.join(args.main_dir, logfile_name))
 
 
+# run the single process pipeline for width p: return the answer ("1" if width < p,
+# the exact width if p = 0), None on error
+def pipeline_answer(args,p,pipeline_exe,logfile,logfile_name):
+    answer_file = args.input + ".answer"
+    command = "{exe} {p} -o {answer} -t {threads} {memory}{lazy}{keep}{cache}{stats}{dfa}".format(exe=pipeline_exe, answer=answer_file,
+                                                                     threads=args.threads,
+                                                                     stats="-s "+args.stats+" " if args.stats else "",
+                                                                     cache="-c "+args.cache+" " if args.cache else "",
+                                                                     p="-e" if p == 0 else "-p "+str(p),
+                                                                     memory="-m " if args.memory else "",
+                                                                     lazy="-l " if args.lazy and p > 0 else "",
+                                                                     keep="-k " if args.keep else "", dfa=args.input)
+    if args.verbose:
+        print("==== check width p =",p,"Command: ", command)
+    if(execute_command(command,logfile,logfile_name)!=True):
+        return None
+    with open(answer_file, 'rb', 0) as a:
+        answer = a.readline().decode()
+    if not args.keep:
+        os.remove(answer_file)
+    return answer
+
 # execute command: return True is everything OK, False otherwise
 def execute_command(command,logfile,logfile_name,env=None):
   try:
@@ -5,6 +5,9 @@
 #include <algorithm>
 #include <fstream>
 #include <string>
+#include <cstdint>
+// buffered parser shared with internal/
+#include "../../internal/text_reader.hpp"
 
 typedef char label_t;
 const label_t empty_label = -1;
@@ -100,43 +103,56 @@ std::ostream& operator << ( std::ostream& out, const std::vector<T>& v ) {
     return out;
 }
 
-template <class COMP>
-std::vector<int> sort_and_get_rank( int n, const COMP& comp ) {
-    // Sort using COMP and return the resulting rank
-    std::vector<int> sorted_idx( n );
-    for( int i = 0; i < n; ++i ) sorted_idx[i] = i;
+// Pointers to the predecessors in CSR form: node i points to ptr[off[i]..off[i+1]).
+struct Pointers {
+    std::vector<int> off;
+    std::vector<int> ptr;
+};
 
-    // TODO to replace with an O(n) sort algorithm in the future
-    std::sort( sorted_idx.begin(), sorted_idx.end(), comp );
+std::vector<int> rank_pairs( const std::vector<int>& key1, const std::vector<int>& key2, int sigma1, int sigma2,
+                             std::vector<int>& I, std::vector<int>& I_, int& nranks ) {
+    // Description: Dense ranks of the pairs (key1[i],key2[i]), 0 <= key1[i] < sigma1 and 0 <= key2[i] < sigma2
+    // Time: O(n+sigma1+sigma2), two counting sort passes (LSD radix sort)
+    // Return: the rank of each pair; nranks is set to the number of distinct pairs
+    const int n = key1.size();
+    std::vector<int> C( std::max( sigma1, sigma2 ) + 1, 0 );
+
+    // Sort by the second key
+    for( int i = 0; i < n; ++i ) C[ key2[i]+1 ]++;
+    for( int c = 1; c <= sigma2; ++c ) C[c] += C[c-1];
+    for( int i = 0; i < n; ++i ) I_[ C[ key2[i] ]++ ] = i;
+
+    // Stable sort by the first key
+    std::fill( C.begin(), C.end(), 0 );
+    for( int i = 0; i < n; ++i ) C[ key1[i]+1 ]++;
+    for( int c = 1; c <= sigma1; ++c ) C[c] += C[c-1];
+    for( int i = 0; i < n; ++i ) I[ C[ key1[ I_[i] ] ]++ ] = I_[i];
 
     std::vector<int> rank( n );
     int r = 0;
     for( int i = 0; i < n; ++i ) {
-        if( i > 0 && comp( sorted_idx[i-1], sorted_idx[i] ) ) ++r;
-        rank[ sorted_idx[i] ] = r;
+        if( i > 0 && ( key1[I[i-1]] != key1[I[i]] || key2[I[i-1]] != key2[I[i]] ) ) ++r;
+        rank[ I[i] ] = r;
     }
+    nranks = ( n > 0 ) ? r+1 : 0;
     return rank;
 }
 
 using namespace std;
 
-static int max_ptrs( const vector<vector<int> >& ptrs ) {
+static int max_ptrs( const Pointers& Ptr ) {
     int m = 0;
-    for( int i = 0; i < ptrs.size(); ++i ) {
-        m = max( m, (int)ptrs[i].size() );
+    for( int i = 0; i+1 < Ptr.off.size(); ++i ) {
+        m = max( m, Ptr.off[i+1] - Ptr.off[i] );
     }
     return m;
 }
 
-static int num_ptrs( const vector<vector<int> >& ptrs ) {
-    int count = 0;
-    for( int i = 0; i < ptrs.size(); ++i ) {
-        count += ptrs[i].size();
-    }
-    return count;
+static int num_ptrs( const Pointers& Ptr ) {
+    return Ptr.ptr.size();
 }
 
-void init_rank( const Graph& G, vector<int>& Rank, vector<vector<int> >& Ptr ) {
+void init_rank( const Graph& G, vector<int>& Rank, Pointers& Ptr, int& nranks ) {
     // Description: Initialize Rank and Ptr with min/max incoming labels
     // Time: O(V+E)
     // Return:
@@ -144,116 +160,129 @@ void init_rank( const Graph& G, vector<int>& Rank, vector<vector<int> >& Ptr ) {
     //       Rank[2*v  ] is the (co-lex) rank of its minimum suffix.
     //       Rank[2*v+1] is the (co-lex) rank of itx maximum suffix.
     //     Ptr: the pointers to the predecessors. This function returns the set of pointers to the source nodes of the incoming edges with the minimum/maximum label.
+    //     nranks: the number of distinct ranks
     const int V = G.V.size();
     const int E = G.E.size();
 
     vector<label_t> min_incoming_label( V, empty_label );
     vector<label_t> max_incoming_label( V, empty_label );
 
-    Ptr = vector<vector<int> >(2*V);
+    for( int i = 0; i < E; ++i ) {
+        int v = G.E[i]->v->id;
+        label_t l = G.E[i]->label;
 
+        if( min_incoming_label[v] == empty_label || l < min_incoming_label[v] ) min_incoming_label[v] = l;
+        if( max_incoming_label[v] == empty_label || max_incoming_label[v] < l ) max_incoming_label[v] = l;
+    }
+
+    // Count the pointers of each node, then fill them
+    Ptr.off.assign( 2*V+1, 0 );
+    for( int i = 0; i < E; ++i ) {
+        int v = G.E[i]->v->id;
+        label_t l = G.E[i]->label;
+        if( l == min_incoming_label[v] ) Ptr.off[2*v+1]++;
+        if( l == max_incoming_label[v] ) Ptr.off[2*v+2]++;
+    }
+    for( int i = 0; i < 2*V; ++i ) Ptr.off[i+1] += Ptr.off[i];
+    Ptr.ptr.resize( Ptr.off[2*V] );
+    vector<int> pos( Ptr.off.begin(), Ptr.off.end()-1 );
     for( int i = 0; i < E; ++i ) {
         int u = G.E[i]->u->id;
         int v = G.E[i]->v->id;
         label_t l = G.E[i]->label;
-
-        if( min_incoming_label[v] == empty_label || l < min_incoming_label[v] ) {
-            min_incoming_label[v] = l;
-            Ptr[2*v  ].clear();
-        }
-        if( max_incoming_label[v] == empty_label || max_incoming_label[v] < l ) {
-            max_incoming_label[v] = l;
-            Ptr[2*v+1].clear();
-        }
-        if( l == min_incoming_label[v] ) { Ptr[2*v  ].push_back( 2*u   ); }
-        if( l == max_incoming_label[v] ) { Ptr[2*v+1].push_back( 2*u+1 ); }
+        if( l == min_incoming_label[v] ) Ptr.ptr[ pos[2*v  ]++ ] = 2*u;
+        if( l == max_incoming_label[v] ) Ptr.ptr[ pos[2*v+1]++ ] = 2*u+1;
     }
 
-    // Sort by incoming edge label.
-    Rank = sort_and_get_rank( 2*V, [&] (int i, int j) {
-            label_t r_i = ((i&0x1)?max_incoming_label[i>>1]:min_incoming_label[i>>1]);
-            label_t r_j = ((j&0x1)?max_incoming_label[j>>1]:min_incoming_label[j>>1]);
-            return r_i < r_j;
-        });
+    // Sort by incoming edge label: labels are compared as label_t, the empty label included
+    const int sigma = 1 << (8*sizeof(label_t));
+    vector<int> key( 2*V ), zero( 2*V, 0 ), I( 2*V ), I_( 2*V );
+    for( int i = 0; i < 2*V; ++i ) {
+        label_t l = (i&0x1)?max_incoming_label[i>>1]:min_incoming_label[i>>1];
+        key[i] = (int)l + sigma/2;
+    }
+    Rank = rank_pairs( key, zero, sigma, 1, I, I_, nranks );
 }
 
-static vector<int> get_pred_rank( vector<int>& Rank, vector<vector<int> >& Ptr ) {
-    // Description: Compute the min/max rank of predecessors 
+static void get_pred_rank( const vector<int>& Rank, const Pointers& Ptr, vector<int>& ret ) {
+    // Description: Compute the min/max rank of predecessors
     // Time: proportional to the total number of pointers
-    // Return: ret[v] is the maximum/minimum rank of v's predecessors
-    vector<int> ret( Rank.size(), -1 );
-    for( int i = 0; i < Ptr.size(); ++i ) {
+    // Return: ret[v] is the maximum/minimum rank of v's predecessors, -1 if none
+    ret.assign( Rank.size(), -1 );
+    for( int i = 0; i < Rank.size(); ++i ) {
         int s = (i&0x1)?1:-1;
-        for( int j = 0; j < Ptr[i].size(); ++j ) {
-            int u = Ptr[i][j];
-            int r = Rank[u];
+        for( int j = Ptr.off[i]; j < Ptr.off[i+1]; ++j ) {
+            int r = Rank[ Ptr.ptr[j] ];
             if( ret[i] == -1 || s*ret[i] < s*r ) {
                 ret[i] = r;
             }
         }
     }
-    return ret;
 }
 
-static vector< vector<int> > get_target_ptr( vector<int>& Rank, vector<int>& targetRank, vector<vector<int> >& Ptr ) {
-    // Description: Leave only pointers to nodes having the rank same as the targetRank
+static void get_target_ptr( const vector<int>& Rank, const vector<int>& targetRank, Pointers& Ptr ) {
+    // Description: Leave only pointers to nodes having the rank same as the targetRank, in place
     // Time: proportional to the total number of pointers
-    // Return: remaining pointers
-    vector<vector<int> > ret( Ptr.size() );
-    
-    for( int i = 0; i < Ptr.size(); ++i ) {
-        for( int j = 0; j < Ptr[i].size(); ++j ) {
-            int u = Ptr[i][j];
-            int r = Rank[u];
-            if( targetRank[i] == r ) {
-                ret[i].push_back( u );
+    int k = 0;
+    for( int i = 0; i < Rank.size(); ++i ) {
+        int beg = Ptr.off[i];
+        Ptr.off[i] = k;
+        for( int j = beg; j < Ptr.off[i+1]; ++j ) {
+            int u = Ptr.ptr[j];
+            if( targetRank[i] == Rank[u] ) {
+                Ptr.ptr[k++] = u;
             }
         }
     }
-    return ret;
-
+    Ptr.off[ Rank.size() ] = k;
+    Ptr.ptr.resize( k );
 }
 
-static vector< vector<int> > get_two_hop_pointers( vector<vector<int> >& Ptr ) {
+static void get_two_hop_pointers( const Pointers& Ptr, Pointers& ret ) {
     // Description: Update the pointers
     // Time: proportional to the total number of pointers before/after merging
     //     the number of iteration of loop for i and j = the number of pointers before merging
-    //     the number of calls of ret[i].push_back() = the number of pointers after merging
-    vector<vector<int> > ret(Ptr.size());
-    for( int i = 0; i < Ptr.size(); ++i ) {
-        for( int j = 0; j < Ptr[i].size(); ++j ) {
-            for( int k = 0; k < Ptr[ Ptr[i][j] ].size(); ++k ) {
-                int p = Ptr[ Ptr[i][j] ][k];
-                ret[i].push_back( p );
+    //     the number of writes to ret.ptr = the number of pointers after merging
+    const int n = Ptr.off.size()-1;
+    ret.off.resize( n+1 );
+    ret.off[0] = 0;
+    for( int i = 0; i < n; ++i ) {
+        ret.off[i+1] = ret.off[i];
+        for( int j = Ptr.off[i]; j < Ptr.off[i+1]; ++j ) {
+            ret.off[i+1] += Ptr.off[ Ptr.ptr[j]+1 ] - Ptr.off[ Ptr.ptr[j] ];
+        }
+    }
+    ret.ptr.resize( ret.off[n] );
+    for( int i = 0, k = 0; i < n; ++i ) {
+        for( int j = Ptr.off[i]; j < Ptr.off[i+1]; ++j ) {
+            for( int h = Ptr.off[ Ptr.ptr[j] ]; h < Ptr.off[ Ptr.ptr[j]+1 ]; ++h ) {
+                ret.ptr[k++] = Ptr.ptr[h];
             }
         }
     }
-    return ret;
 }
 
-static void doubling( const Graph& G, vector<int>& Rank, vector<vector<int> >& Ptr ) {
-    // Description: a doubling procedure
+static void doubling( const Graph& G, vector<int>& Rank, Pointers& Ptr, int& nranks,
+                      vector<int>& nextrank, vector<int>& I, vector<int>& I_, Pointers& tmp ) {
+    // Description: a doubling procedure; nextrank, I, I_ and tmp are work buffers
 
-    // Sort the node using the pairs of ranks
-    vector<int> nextrank = get_pred_rank( Rank, Ptr );
-    Rank = sort_and_get_rank( Rank.size(), [&] (int i, int j) {
-            if( Rank[i] < Rank[j] ) return true;
-            if( Rank[i] > Rank[j] ) return false;
-
-            return nextrank[i] < nextrank[j];
-        });
+    // Sort the node using the pairs of ranks; -1 (no predecessor) is the smallest
+    get_pred_rank( Rank, Ptr, nextrank );
+    for( int i = 0; i < nextrank.size(); ++i ) nextrank[i]++;
+    Rank = rank_pairs( Rank, nextrank, nranks, nranks+1, I, I_, nranks );
 
     // Remove pointers to nodes with non-{min/max} ranks
-    nextrank = get_pred_rank( Rank, Ptr );
-    Ptr = get_target_ptr( Rank, nextrank, Ptr );
+    get_pred_rank( Rank, Ptr, nextrank );
+    get_target_ptr( Rank, nextrank, Ptr );
 
     // Update the pointers
-    Ptr = get_two_hop_pointers( Ptr ); 
+    get_two_hop_pointers( Ptr, tmp );
+    swap( Ptr, tmp );
 
     // In fact, one more filtering step is needed to ensure that the predecessors of a node have the same rank.
     // Or, the pointer-removal above should look 2-hops farther.
-    //nextrank = get_pred_rank( Rank, Ptr );
-    //Ptr = get_target_ptr( Rank, nextrank, Ptr );
+    //get_pred_rank( Rank, Ptr, nextrank );
+    //get_target_ptr( Rank, nextrank, Ptr );
 
 }
 
@@ -261,34 +290,46 @@ vector<int> sort_graph( const Graph& G ) {
     const int V = G.V.size();
     const int E = G.E.size();
     vector<int> Rank;
-    vector<vector<int> > Ptr;
+    Pointers Ptr, tmp;
+    int nranks = 0;
 
-    init_rank( G, Rank, Ptr );
+    init_rank( G, Rank, Ptr, nranks );
     //cout << "L=1" << endl;
     //cout << Rank  << endl;
-    //cout << Ptr   << endl;
 
     int countmax = num_ptrs( Ptr );
     int nummax = max_ptrs( Ptr );
     int l = 1;
 
-    while( l < 4*V ) {
-        doubling( G, Rank, Ptr );
+    // work buffers shared by all the rounds
+    vector<int> nextrank( 2*V ), I( 2*V ), I_( 2*V );
+
+    // The ranks do not change any more once they are all distinct or no pointer is left
+    while( l < 4*V && nranks < 2*V && Ptr.ptr.size() > 0 ) {
+        doubling( G, Rank, Ptr, nranks, nextrank, I, I_, tmp );
         l <<= 1;
 
         countmax = max(countmax, num_ptrs( Ptr ) );
         nummax = max(nummax, max_ptrs( Ptr ) );
         //cout << "L=" << l << endl;
         //cout << Rank  << endl;
-        //cout << Ptr   << endl;
     }
     return Rank;
 }
 
-bool load_edge_list( Graph& G, istream& in, int voffset ) {
+// read origin, label and destination of a transition, as operator>> with an int, a label_t and an int
+bool read_edge( text_reader& in, int& u, label_t& l, int& v ) {
+    uint64_t u_, v_;
+    if( !( in.scan_uint( u_ ) && in.scan_char( l ) && in.scan_uint( v_ ) ) ) return false;
+    u = (int)u_;
+    v = (int)v_;
+    return true;
+}
+
+bool load_edge_list( Graph& G, text_reader& in, int voffset ) {
     int u, v;
     label_t l;
-    while( in >> u >> l >> v ) {
+    while( read_edge( in, u, l, v ) ) {
         u += voffset;
         v += voffset;
         if( !G.add_edge( u, v, l ) ) {
@@ -296,20 +337,20 @@ bool load_edge_list( Graph& G, istream& in, int voffset ) {
             return false;
         }
     }
-    string tok;
-    if( in >> tok ) { 
+    char tok;
+    if( in.scan_char( tok ) ) { 
         cerr << "Warning: data not consumed completely" << endl;
     }
     return true;
 }
 
-bool load_dfafile( Graph& G, istream& in, int voffset ) {
-    int n, m, s, f;
-    if( !(in >> n >> m >> s >> f) ) return false;
-    for( int i = 0; i < m; ++i ) {
+bool load_dfafile( Graph& G, text_reader& in, int voffset ) {
+    uint64_t n, m, s, f;
+    if( !( in.scan_uint( n ) && in.scan_uint( m ) && in.scan_uint( s ) && in.scan_uint( f ) ) ) return false;
+    for( uint64_t i = 0; i < m; ++i ) {
         int u, v;
         label_t l;
-        if( !( in >> u >> l >> v ) ) {
+        if( !read_edge( in, u, l, v ) ) {
             cerr << "Error: data not consumed completely. probably wrong format." << endl;
 
         }
@@ -320,12 +361,12 @@ bool load_dfafile( Graph& G, istream& in, int voffset ) {
             return false;
         }
     }
-    for( int i = 0; i < f; ++i ) {
-        int u;
-        in >> u;
+    for( uint64_t i = 0; i < f; ++i ) {
+        uint64_t u;
+        in.scan_uint( u );
     }
-    string tok;
-    if( in >> tok ) { 
+    char tok;
+    if( in.scan_char( tok ) ) { 
         cerr << "Warning: data not consumed completely. probably wrong format." << endl;
     }
     
@@ -333,9 +374,45 @@ bool load_dfafile( Graph& G, istream& in, int voffset ) {
     return true;
 }
 
+// read n values of type T, skipping the padding to a multiple of 8 bytes
+template <typename T>
+bool read_padded( text_reader& in, vector<T>& a, uint64_t n ) {
+    a.resize( n );
+    char pad[8];
+    size_t p = (n*sizeof(T)+7)/8*8 - n*sizeof(T);
+    return in.read( a.data(), n*sizeof(T) ) == n*sizeof(T) && in.read( pad, p ) == p;
+}
+
+// binary DFA of internal/binary.hpp: 16 bytes header, nodes edges source accepting
+// as 64 bit integers, then the origin, destination and label arrays
+bool load_dfafile_binary( Graph& G, text_reader& in, int voffset ) {
+    char header[16];
+    uint64_t h[4];
+    if( in.read( header, 16 ) != 16 || string( header, 4 ) != "DWBF" ) return false;
+    if( in.read( h, sizeof(h) ) != sizeof(h) ) return false;
+    vector<uint32_t> origin, dest;
+    vector<unsigned char> label;
+    if( !read_padded( in, origin, h[1] ) || !read_padded( in, dest, h[1] ) || !read_padded( in, label, h[1] ) ) {
+        cerr << "Error: truncated binary DFA" << endl;
+        return false;
+    }
+    for( uint64_t i = 0; i < h[1]; ++i ) {
+        int u = origin[i] + voffset;
+        int v = dest[i] + voffset;
+        if( !G.add_edge( u, v, (label_t)label[i] ) ) {
+            cerr << "Error: something wrong in data: " << u << ',' << v << ',' << (int)label[i] << endl;
+            return false;
+        }
+    }
+    return true;
+}
+
 int main( int argc, char **argv ) {
     Graph G;
-    if( !load_dfafile( G, cin, 0 ) ) return 1;
+    // text or binary DFA from the standard input
+    text_reader in( "-" );
+    bool binary = in.peek() == 'D';
+    if( !( binary ? load_dfafile_binary( G, in, 0 ) : load_dfafile( G, in, 0 ) ) ) return 1;
     // Sort and compute the co-lex rank of nodes
     vector<int> ranks = sort_graph( G );
     for( int i = 0; i < ranks.size()/2; ++i ) {
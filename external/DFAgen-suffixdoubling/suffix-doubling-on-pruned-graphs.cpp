@@ -2,6 +2,10 @@
 #include <iostream>
 #include <fstream>
 #include <cassert>
+#include <cstdint>
+#include <string>
+// buffered parser shared with internal/
+#include "../../internal/text_reader.hpp"
 
 using namespace std;
 
@@ -118,14 +122,49 @@ int get_char_id( char a ) {
     }
 }
 
-void load_input( istream& in ) {
+// pruned graph in the binary format of internal/binary.hpp: 16 bytes header, nodes
+// edges source accepting as 64 bit integers, then the origin, destination and label
+// arrays padded to multiples of 8 bytes
+void load_input_binary( text_reader& in ) {
     int offset = N;
-    int u_, v_;
+    char header[16], pad[8];
+    uint64_t h[4];
+    in.read( header, 16 );
+    in.read( h, sizeof(h) );
+    assert( string( header, 4 ) == "DWBF" );
+    vector<uint32_t> origin( h[1] ), dest( h[1] );
+    vector<char> label( h[1] );
+    size_t p = (4*h[1]+7)/8*8 - 4*h[1];
+    bool ok = in.read( origin.data(), 4*h[1] ) == 4*h[1] && in.read( pad, p ) == p
+           && in.read( dest.data(), 4*h[1] ) == 4*h[1] && in.read( pad, p ) == p
+           && in.read( label.data(), h[1] ) == h[1];
+    assert( ok ); (void)ok;
+    int max_a = 0;
+    for( uint64_t i = 0; i < h[1]; ++i ) {
+        int u = origin[i] + offset;
+        int v = dest[i] + offset;
+        int a = (int)label[i];
+
+        max_a = max( max_a, a );
+        check_size( max( u, v ) );
+
+        In[v] = 1;
+        R [v] = a;
+        P [v] = u;
+    }
+
+    if( max_a >= N ) C.resize( max_a + 1 );
+}
+
+void load_input( text_reader& in ) {
+    if( in.peek() == 'D' ) { load_input_binary( in ); return; }
+    int offset = N;
+    uint64_t u_, v_;
     char a_;
     int max_a = 0;
-    while( in >> u_ >> a_ >> v_ ) {
-        int u = u_ + offset;
-        int v = v_ + offset;
+    while( in.scan_uint( u_ ) && in.scan_char( a_ ) && in.scan_uint( v_ ) ) {
+        int u = (int)u_ + offset;
+        int v = (int)v_ + offset;
         //int a = get_char_id( a_ );
         int a = (int)a_;
 
@@ -142,8 +181,8 @@ void load_input( istream& in ) {
 
 int main( int argc, char **argv ) {
     {
-        ifstream in_min( argv[1] ); // pruned graph for infima
-        ifstream in_max( argv[2] ); // pruned graph for suprema
+        text_reader in_min( argv[1] ); // pruned graph for infima
+        text_reader in_max( argv[2] ); // pruned graph for suprema
         load_input( in_min );
         load_input( in_max );
         assert( N%2 == 0 );
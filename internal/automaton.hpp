@@ -3,6 +3,7 @@
 
 #include <cstdint>
 #include <cassert>
+#include <algorithm>
 #include <vector>
 #include <unordered_set>
 #include <unordered_map>
@@ -10,7 +11,7 @@
 #include <stack>
 #include <fstream>
 #include <sstream>
-// hash function for unordered sets
+// hash mixing function for state tuples
 #include "hashing_function.hpp"
 
 #ifndef M64
@@ -25,133 +26,634 @@
     #define I_MAX   INT64_MAX
 #endif
 
-// container for an order agnostic hash function
-template <typename Container>
-struct container_hash {
-    std::size_t operator()(Container const& c) const {
-        return hash_unordered_range(c.begin(),c.end());
-    }
+// sorting networks for 3 to 8 elements: the compare-exchange pairs, in order
+template <uint P>
+struct sorting_network;
+template <>
+struct sorting_network<3>{ static constexpr uint8_t pairs[][2] = {{0,2},{0,1},{1,2}}; };
+template <>
+struct sorting_network<4>{ static constexpr uint8_t pairs[][2] = {{0,1},{2,3},{0,2},{1,3},{1,2}}; };
+template <>
+struct sorting_network<5>
+{
+	static constexpr uint8_t pairs[][2] = {{0,3},{1,4},{0,2},{1,3},{0,1},{2,4},{1,2},{3,4},{2,3}};
+};
+template <>
+struct sorting_network<6>
+{
+	static constexpr uint8_t pairs[][2] = {{0,5},{1,3},{2,4},{1,2},{3,4},{0,3},{2,5},{0,1},{2,3},{4,5},{1,2},{3,4}};
+};
+template <>
+struct sorting_network<7>
+{
+	static constexpr uint8_t pairs[][2] = {{0,6},{2,3},{4,5},{0,2},{1,4},{3,6},{0,1},{2,5},{3,4},{1,2},{4,6},{2,3},
+	                                       {4,5},{1,2},{3,4},{5,6}};
+};
+template <>
+struct sorting_network<8>
+{
+	static constexpr uint8_t pairs[][2] = {{0,2},{1,3},{4,6},{5,7},{0,4},{1,5},{2,6},{3,7},{0,1},{2,3},{4,5},{6,7},
+	                                       {2,4},{3,5},{1,4},{3,6},{1,2},{3,4},{5,6}};
 };
 
 /*
-	node of the DFA
+	set of p-tuples of states of the minimum DFA (states of A^p). Tuple k is stored
+	sorted in arena[k*p,(k+1)*p), followed by a scratch tuple filled by the caller
+	before find and insert; the open addressing table stores tuple ids. The
+	operations on tuples take the width as template argument P when it is known
+	at compile time, so that their loops are unrolled; P = 0 uses p.
 */
-struct node
+class tuple_set
 {
-	node(){}
-	node(char label){ labels.push_back(label); }
-	node(char label, uint value){ out.insert({label,value}); }
-
-	void add_edge(char label, uint value){ out.insert({label,value}); }
-	void add_label(char label){ labels.push_back(label); }
-	
-	// out edges
-	std::unordered_map<char,uint> out;
-	// labels list
-	std::vector<char> labels;
-};
+public:
+	tuple_set(){ p = n = 0; }
+	tuple_set(uint p_)
+	{
+		p = p_; n = 0;
+		arena.resize(p);
+		table.assign(16,U_MAX);
+	}
 
-// class for directed bidirectional unlabeled NFA
-template <typename Container>
-class DFA_unidirectional_out_labelled{
+	uint width(){ return p; }
+	uint size(){ return n; }
+	// slots of the hash table (load factor size()/slots() < 1/2) and number of rehashes
+	size_t slots(){ return table.size(); }
+	uint rehashes(){ return grown; }
+
+	// pointer to the tuple with id k
+	const uint* at(uint k)
+	{
+		assert(k < n);
+		return &arena[size_t(k)*p];
+	}
+
+	// pointer to the scratch tuple; invalidated by insert
+	uint* scratch(){ return &arena[size_t(n)*p]; }
+
+	// sort the scratch tuple; return false if it contains a state twice
+	template <uint P = 0>
+	bool normalize(){ return sort_tuple<P>(scratch(),p); }
+
+	// sort the tuple t of p states; return false if it contains a state twice. For
+	// 3 <= P <= 8 a sorting network of branchless compare-exchanges is used, since
+	// the order of the successor tuples is random and the branches mispredict
+	template <uint P = 0>
+	static bool sort_tuple(uint* t, uint p)
+	{
+		const uint w = P ? P : p;
+		if( w == 2 )
+		{
+			if( t[0] > t[1] ){ std::swap(t[0],t[1]); }
+			return t[0] != t[1];
+		}
+		if constexpr( P >= 3 && P <= 8 )
+		{
+			for(auto& c: sorting_network<P>::pairs)
+			{
+				uint x = t[c[0]], y = t[c[1]];
+				t[c[0]] = std::min(x,y);
+				t[c[1]] = std::max(x,y);
+			}
+			bool distinct = true;
+			for(uint i=1;i<P;++i){ distinct &= (t[i-1] != t[i]); }
+			return distinct;
+		}
+		for(uint i=1;i<w;++i)
+		{
+			uint x = t[i], j = i;
+			for(;j>0 && t[j-1]>x;--j){ t[j] = t[j-1]; }
+			t[j] = x;
+		}
+		for(uint i=1;i<w;++i)
+			if( t[i-1] == t[i] ){ return false; }
+		return true;
+	}
+
+	// id of the (sorted) scratch tuple, U_MAX if absent
+	template <uint P = 0>
+	uint find()
+	{
+		return table[slot<P>(scratch())];
+	}
+
+	// id of the sorted tuple t, U_MAX if absent; does not write, so concurrent
+	// calls are safe while no tuple is inserted
+	template <uint P = 0>
+	uint find(const uint* t)
+	{
+		return table[slot<P>(t)];
+	}
+
+	// batched searches: home(t) is the slot where the search of the sorted tuple t
+	// starts and prefetch loads it, so that the cache misses of a batch of
+	// searches overlap before find(t,h) runs them
+	template <uint P = 0>
+	size_t home(const uint* t){ return hash<P>(t) & (table.size()-1); }
+	void prefetch(size_t h) const { __builtin_prefetch(&table[h]); }
+	template <uint P = 0>
+	uint find(const uint* t, size_t h)
+	{
+		return table[slot<P>(t,h)];
+	}
+
+	// make room for n tuples without rehashing
+	void reserve(uint n_)
+	{
+		arena.reserve(size_t(n_+1)*p);
+		size_t m = table.size();
+		while( m < 2*size_t(n_) ){ m *= 2; }
+		if( m > table.size() ){ rehash(m); }
+	}
+
+	// insert the (sorted) scratch tuple; return its id and whether it is new
+	template <uint P = 0>
+	std::pair<uint,bool> insert()
+	{
+		size_t s = slot<P>(scratch());
+		if( table[s] != U_MAX ){ return {table[s],false}; }
+		table[s] = n++;
+		arena.resize(size_t(n+1)*p);
+		// keep the load factor below 1/2
+		if( 2*size_t(n) > table.size() ){ grown++; rehash(2*table.size()); }
+		return {n-1,true};
+	}
 
+	// empty the set for tuples of width p_, keeping the memory of arena and table
+	void reset(uint p_)
+	{
+		p = p_; n = grown = 0;
+		arena.clear();
+		arena.resize(p);
+		table.assign(16,U_MAX);
+	}
+
+	// empty the set and release the memory
+	void clear()
+	{
+		n = grown = 0;
+		arena.resize(p);
+		arena.shrink_to_fit();
+		table.assign(16,U_MAX);
+		table.shrink_to_fit();
+	}
+
+private:
+
+	template <uint P = 0>
+	size_t hash(const uint* t)
+	{
+		const uint w = P ? P : p;
+		size_t h = 0;
+		for(uint i=0;i<w;++i){ hash_combine(h,t[i]); }
+		return h;
+	}
+
+	// table slot containing the tuple t or the empty slot where it belongs,
+	// searching from slot s (def. its home slot)
+	template <uint P = 0>
+	size_t slot(const uint* t)
+	{
+		return slot<P>(t,home<P>(t));
+	}
+	template <uint P = 0>
+	size_t slot(const uint* t, size_t s)
+	{
+		const uint w = P ? P : p;
+		size_t mask = table.size()-1;
+		while( table[s] != U_MAX && !std::equal(t,t+w,&arena[size_t(table[s])*w]) )
+			s = (s+1) & mask;
+		return s;
+	}
+
+	// rebuild the table with m slots
+	void rehash(size_t m)
+	{
+		std::vector<uint> old(m,U_MAX);
+		table.swap(old);
+		size_t mask = table.size()-1;
+		for(auto& k: old)
+		{
+			if( k == U_MAX ){ continue; }
+			size_t s = hash(&arena[size_t(k)*p]) & mask;
+			while( table[s] != U_MAX ){ s = (s+1) & mask; }
+			table[s] = k;
+		}
+	}
+
+	// tuple width, number of tuples and of rehashes caused by the load (not by reserve)
+	uint p, n, grown = 0;
+	// tuples followed by the scratch tuple
+	std::vector<uint> arena;
+	// open addressing table of tuple ids
+	std::vector<uint> table;
+};
+
+/*
+	set of pairs of states of the minimum DFA (states of A^2), packed in 64-bit
+	keys with the smaller state in the high half. The open addressing table
+	stores the keys, so a lookup reads one array, and the ids of the pairs in a
+	parallel array; keys[k] is the pair with id k. Requires 32-bit states.
+*/
+class pair_set
+{
 public:
+	pair_set(){ clear(); }
 
-	// define unordered map type
-	typedef std::unordered_map<Container,uint,container_hash<Container>> mapt;
-	// empty constructor
-	DFA_unidirectional_out_labelled(){ nodes = edges = 0; }
-	// constructor 
-	DFA_unidirectional_out_labelled(uint n)
+	// key of the pair {u,v}
+	static uint64_t pack(uint u, uint v)
 	{
-		nodes = n;
-		//initialize DFA
-		DFA.resize(nodes);
+		return u < v ? (uint64_t(u) << 32) | v : (uint64_t(v) << 32) | u;
 	}
-	// destructor
-	// ~DFA_unidirectional_out_labelled(){}
+	static uint first(uint64_t x){ return static_cast<uint>(x >> 32); }
+	static uint second(uint64_t x){ return static_cast<uint>(x & 0xffffffffULL); }
 
-	node* at(uint i){
+	uint size(){ return static_cast<uint>(keys.size()); }
+	// slots of the hash table (load factor size()/slots() < 1/2) and number of rehashes
+	size_t slots(){ return table.size(); }
+	uint rehashes(){ return grown; }
 
-		assert(i < nodes);
-		// return pointer to node
-		return &DFA[i];
+	// key of the pair with id k
+	uint64_t key(uint k){ assert(k < keys.size()); return keys[k]; }
+
+	// id of the pair with key x, U_MAX if absent; safe to call concurrently while
+	// no pair is inserted
+	uint find(uint64_t x) const
+	{
+		size_t s = slot(x);
+		return table[s] == empty ? U_MAX : ids[s];
 	}
 
-	uint no_nodes(){ return nodes; }
-	uint no_edges(){ return edges; }
+	// insert the pair with key x; return its id and whether it is new
+	std::pair<uint,bool> insert(uint64_t x)
+	{
+		size_t s = slot(x);
+		if( table[s] != empty ){ return {ids[s],false}; }
+		table[s] = x;
+		ids[s] = static_cast<uint>(keys.size());
+		keys.push_back(x);
+		// keep the load factor below 1/2
+		if( 2*keys.size() > table.size() ){ grown++; rehash(2*table.size()); }
+		return {ids[s],true};
+	}
+
+	// make room for n pairs without rehashing
+	void reserve(size_t n)
+	{
+		keys.reserve(n);
+		size_t m = table.size();
+		while( m < 2*n ){ m *= 2; }
+		if( m > table.size() ){ rehash(m); }
+	}
+
+	void clear()
+	{
+		grown = 0;
+		std::vector<uint64_t>().swap(keys);
+		std::vector<uint>().swap(ids);
+		table.assign(16,empty);
+		table.shrink_to_fit();
+		ids.resize(16);
+	}
+
+private:
 
-	void add_state(Container& v)
+	// the key of (U_MAX,U_MAX), never a state
+	static constexpr uint64_t empty = UINT64_MAX;
+
+	// 64-bit finalizer of MurmurHash3
+	static size_t hash(uint64_t x)
+	{
+		x ^= x >> 33; x *= 0xff51afd7ed558ccdULL;
+		x ^= x >> 33; x *= 0xc4ceb9fe1a85ec53ULL;
+		x ^= x >> 33;
+		return static_cast<size_t>(x);
+	}
+
+	// table slot containing the key x or the empty slot where it belongs
+	size_t slot(uint64_t x) const
 	{
-		if (M.find(v) == M.end())
+		size_t mask = table.size()-1;
+		size_t s = hash(x) & mask;
+		while( table[s] != empty && table[s] != x ){ s = (s+1) & mask; }
+		return s;
+	}
+
+	// rebuild the table with m slots
+	void rehash(size_t m)
+	{
+		table.assign(m,empty);
+		ids.resize(m);
+		size_t mask = m-1;
+		for(uint k=0;k<keys.size();++k)
 		{
-			M.insert({v,nodes++});
-			DFA.push_back(node());
+			size_t s = hash(keys[k]) & mask;
+			while( table[s] != empty ){ s = (s+1) & mask; }
+			table[s] = keys[k];
+			ids[s] = k;
 		}
 	}
 
-	void add_state(Container& v, char label)
+	// keys by id
+	std::vector<uint64_t> keys;
+	// open addressing table of keys and the ids of its slots
+	std::vector<uint64_t> table;
+	std::vector<uint> ids;
+	uint grown;
+};
+
+/*
+	transition of a DFA stored as an edge list
+*/
+struct transition
+{
+	uint origin;
+	char label;
+	uint dest;
+};
+
+/*
+	DFA stored as a list of transitions (input and minimum DFA)
+*/
+struct DFA_edge_list
+{
+	DFA_edge_list(){ nodes = source = 0; }
+
+	void add_edge(uint origin, char label, uint dest){ edges.push_back({origin,label,dest}); }
+
+	// number of states
+	uint nodes;
+	// source state
+	uint source;
+	// transitions
+	std::vector<transition> edges;
+	// accepting states
+	std::vector<uint> accepting;
+};
+
+/*
+	read-only minimum DFA. The transitions of state s are stored sorted by label in
+	positions [first(s),last(s)) of the label and dest arrays; with a small
+	alphabet a dense table gives the destination of every pair (state, label
+	index), otherwise next() binary searches the row of the state.
+*/
+class min_dfa
+{
+public:
+	min_dfa(){ n = 0; dense = false; std::fill(code,code+256,U_MAX); }
+	min_dfa(const DFA_edge_list& D) : min_dfa(D.nodes,D.edges.size(),[&](size_t i) -> const transition& { return D.edges[i]; }){}
+	// DFA with the given number of states and m transitions; edge(i) returns transition i
+	template <typename Edge>
+	min_dfa(uint nodes, size_t m, Edge edge) : min_dfa()
 	{
-		auto entry = M.find(v);
-		if (entry == M.end())
+		n = nodes;
+
+		// alphabet
+		for(size_t i=0;i<m;++i){ code[static_cast<unsigned char>(edge(i).label)] = 0; }
+		for(uint c=0;c<256;++c)
+			if( code[c] != U_MAX )
+			{
+				code[c] = static_cast<uint>(sigma.size());
+				sigma.push_back(char(c));
+			}
+
+		// counting sort of the transitions by label, then by origin
+		std::vector<uint> count(sigma.size()+1,0), by_label(m);
+		for(size_t i=0;i<m;++i){ count[code_of(edge(i).label)+1]++; }
+		for(size_t c=1;c<count.size();++c){ count[c] += count[c-1]; }
+		for(uint i=0;i<m;++i){ by_label[count[code_of(edge(i).label)]++] = i; }
+
+		off.assign(size_t(n)+1,0);
+		for(size_t i=0;i<m;++i){ off[edge(i).origin+1]++; }
+		for(uint s=0;s<n;++s){ off[s+1] += off[s]; }
+		label.resize(m);
+		dest.resize(m);
+		std::vector<uint> pos(off.begin(),off.end()-1);
+		for(auto i: by_label)
 		{
-			M.insert({v,nodes++});
-			DFA.push_back(node(label));
+			const transition e = edge(i);
+			label[pos[e.origin]] = e.label;
+			dest[pos[e.origin]++] = e.dest;
 		}
-		else
+
+		// dense transition table for small alphabets
+		dense = sigma.size() <= dense_sigma;
+		if( dense )
 		{
-			DFA[entry->second].add_label(label);
+			table.assign(size_t(n)*sigma.size(),U_MAX);
+			for(uint s=0;s<n;++s)
+				for(uint e=off[s];e<off[s+1];++e)
+					table[size_t(s)*sigma.size()+code_of(label[e])] = dest[e];
 		}
 	}
 
-	mapt* give_mapping()
+	uint no_states() const { return n; }
+	uint no_edges() const { return static_cast<uint>(dest.size()); }
+
+	// transitions of state s: positions [first(s),last(s))
+	uint first(uint s) const { assert(s < n); return off[s]; }
+	uint last(uint s) const { assert(s < n); return off[s+1]; }
+	char label_at(uint e) const { return label[e]; }
+	uint dest_at(uint e) const { return dest[e]; }
+
+	// labels of the DFA, sorted
+	const std::vector<char>& alphabet() const { return sigma; }
+	// index of label a in the alphabet, U_MAX if a is not a label of the DFA
+	uint code_of(char a) const { return code[static_cast<unsigned char>(a)]; }
+
+	// destination of the transition from s labelled a, U_MAX if missing
+	uint next(uint s, char a) const
 	{
-		return &M;
+		uint c = code_of(a);
+		if( c == U_MAX ){ return U_MAX; }
+		if( dense ){ return table[size_t(s)*sigma.size()+c]; }
+		uint lo = off[s], hi = off[s+1];
+		while( lo < hi )
+		{
+			uint mid = lo + (hi-lo)/2;
+			uint cm = code_of(label[mid]);
+			if( cm == c ){ return dest[mid]; }
+			if( cm < c ){ lo = mid+1; } else { hi = mid; }
+		}
+		return U_MAX;
+	}
+
+	// destinations of the transitions labelled a from the p states of s, written to
+	// t; false if one of them is missing. With the dense table the loads from the
+	// column of a are independent and the missing transitions are tested once, so
+	// the loop compiles to a gather
+	template <uint P = 0>
+	bool next_all(const uint* s, char a, uint* t, uint p) const
+	{
+		const uint w = P ? P : p;
+		uint c = code_of(a);
+		if( c == U_MAX ){ return false; }
+		if( dense )
+		{
+			const uint* col = table.data()+c;
+			const size_t k = sigma.size();
+			bool ok = true;
+			for(uint i=0;i<w;++i)
+			{
+				t[i] = col[size_t(s[i])*k];
+				ok &= (t[i] != U_MAX);
+			}
+			return ok;
+		}
+		for(uint i=0;i<w;++i)
+			if( (t[i] = next(s[i],a)) == U_MAX ){ return false; }
+		return true;
 	}
 
-	void add_edge(uint i,char key,uint value)
+private:
+	// largest alphabet with a dense transition table
+	static const uint dense_sigma = 32;
+
+	// number of states
+	uint n;
+	// CSR transitions, sorted by label in every row
+	std::vector<uint> off;
+	std::vector<char> label;
+	std::vector<uint> dest;
+	// alphabet and label -> alphabet index
+	std::vector<char> sigma;
+	uint code[256];
+	// dense table of destinations
+	bool dense;
+	std::vector<uint> table;
+};
+
+/*
+	A^p automaton: the states are the tuples of the mapping and every state keeps
+	the labels generating it, in insertion order, as a list of cells in a single
+	arena; the edges are stored apart, in CSR form. Nothing is allocated per
+	state, so reset() is O(1) and keeps the buffers for the next construction.
+*/
+template <typename Container>
+class DFA_unidirectional_out_labelled{
+
+public:
+
+	// define state mapping type
+	typedef Container mapt;
+
+	// label of a state and next cell of the same state (U_MAX if last)
+	struct label_cell
+	{
+		char label;
+		uint next;
+	};
+
+	// labels of a state, in insertion order
+	class label_list
+	{
+	public:
+		struct iterator
+		{
+			const label_cell* cells;
+			uint c;
+			char operator*() const { return cells[c].label; }
+			iterator& operator++(){ c = cells[c].next; return *this; }
+			bool operator!=(const iterator& o) const { return c != o.c; }
+		};
+
+		label_list(const label_cell* cells_, uint first_) : cells(cells_), first(first_){}
+		iterator begin() const { return {cells,first}; }
+		iterator end() const { return {cells,U_MAX}; }
+
+	private:
+		const label_cell* cells;
+		uint first;
+	};
+
+	// empty constructor
+	DFA_unidirectional_out_labelled(){ nodes = 0; }
+	// constructor for the A^p automaton, whose states are p-tuples
+	DFA_unidirectional_out_labelled(uint n, uint p) : M(p)
+	{
+		nodes = 0;
+		reserve(n,n);
+	}
+
+	uint no_nodes(){ return nodes; }
+
+	// labels of state i; invalidated by add_state and add_label
+	label_list labels(uint i)
 	{
 		assert(i < nodes);
-		// increase edge number
-		edges++;
-		// insert edge
-		DFA[i].out.insert({key,value});
+		return label_list(cells.data(),head[i]);
+	}
+
+	// add the state stored (sorted) in the scratch tuple of the mapping, generated by
+	// label; returns its id
+	template <uint P = 0>
+	uint add_state(char label)
+	{
+		auto entry = M.template insert<P>();
+		if (entry.second)
+		{
+			nodes++;
+			head.push_back(static_cast<uint>(cells.size()));
+			tail.push_back(static_cast<uint>(cells.size()));
+			cells.push_back({label,U_MAX});
+		}
+		else
+		{
+			add_label(entry.first,label);
+		}
+		return entry.first;
 	}
 
-	void remove_label(uint i,char key)
+	// append label to the labels of state i
+	void add_label(uint i, char label)
 	{
 		assert(i < nodes);
-		// delete label
-		DFA[i].out.erase(key);
+		uint c = static_cast<uint>(cells.size());
+		cells.push_back({label,U_MAX});
+		cells[tail[i]].next = c;
+		tail[i] = c;
 	}
 
-	void clear()
+	// make room for n states and m labels
+	void reserve(uint n, size_t m)
 	{
-		DFA.resize(0);
-		DFA.shrink_to_fit();
-		M.clear();
+		M.reserve(n);
+		head.reserve(n);
+		tail.reserve(n);
+		cells.reserve(m);
 	}
 
-	void clear_nodes()
+	mapt* give_mapping()
 	{
-		DFA.resize(0);
-		DFA.shrink_to_fit();
+		return &M;
 	}
 
-	void clear_labels(uint i)
+	// empty the automaton for states of width p, keeping the memory
+	void reset(uint p)
 	{
-		assert(i < nodes);
-		// clear label vector
-		DFA[i].labels.clear();
+		nodes = 0;
+		head.clear();
+		tail.clear();
+		cells.clear();
+		M.reset(p);
+	}
+
+	// empty the automaton and release the memory
+	void clear()
+	{
+		nodes = 0;
+		std::vector<uint>().swap(head);
+		std::vector<uint>().swap(tail);
+		std::vector<label_cell>().swap(cells);
+		M.clear();
 	}
 
 private:
 	// number of nodes in the DFA
 	uint nodes;
-	// number of edges in the DFA
-	uint edges;
-	// vector containing all edges
-	std::vector<node> DFA;
+	// first and last label cell of every state
+	std::vector<uint> head, tail;
+	// arena of the label lists
+	std::vector<label_cell> cells;
 	// mapping vector -> position in DFA vector
 	mapt M;
 };
@@ -0,0 +1,84 @@
+#include <unistd.h>
+#include "automaton.hpp"
+#include "utils.hpp"
+// synthetic DFA families
+#include "workloads.hpp"
+
+void print_help( void )
+{
+    std::cout << "usage: bench-gen.x [options] output.dfa" << std::endl;
+    std::cout << " -f [family] : random, chains or scaled (def. random)" << std::endl;
+    std::cout << " -n [num]    : random: number of states (def. 1000)" << std::endl;
+    std::cout << " -s [sigma]  : random: alphabet size (def. 4)" << std::endl;
+    std::cout << " -i [indeg]  : random: indegree (def. 2)" << std::endl;
+    std::cout << " -a [#edge]  : random: additional random transitions (def. n)" << std::endl;
+    std::cout << " -B          : random: allow backward transitions" << std::endl;
+    std::cout << " -r [seed]   : random: random seed (def. 1)" << std::endl;
+    std::cout << " -p [p]      : chains: number of chains, i.e. the width (def. 2)" << std::endl;
+    std::cout << " -l [len]    : chains: length of the chains (def. 10)" << std::endl;
+    std::cout << " -d [dfa]    : scaled: input DFA (def. data/regexp.dfa)" << std::endl;
+    std::cout << " -k [copies] : scaled: number of concatenated copies (def. 10)" << std::endl;
+    std::cout << " -b          : write the DFA in the binary format" << std::endl;
+}
+
+int main(int argc, char** argv)
+{
+    int opt;
+    std::string family = "random", base = "data/regexp.dfa";
+    uint n = 1000, sigma = 4, indeg = 2, extra = U_MAX, seed = 1, p = 2, len = 10, copies = 10;
+    bool backward = false, binary = false;
+    while( ( opt = getopt( argc, argv, "f:n:s:i:a:r:p:l:d:k:Bbh" ) ) != -1 )
+    {
+        switch( opt )
+        {
+            case 'f': family = std::string(optarg); break;
+            case 'n': n = read_uint<uint>(optarg); break;
+            case 's': sigma = read_uint<uint>(optarg); break;
+            case 'i': indeg = read_uint<uint>(optarg); break;
+            case 'a': extra = read_uint<uint>(optarg); break;
+            case 'r': seed = read_uint<uint>(optarg); break;
+            case 'p': p = read_uint<uint>(optarg); break;
+            case 'l': len = read_uint<uint>(optarg); break;
+            case 'd': base = std::string(optarg); break;
+            case 'k': copies = read_uint<uint>(optarg); break;
+            case 'B': backward = true; break;
+            case 'b': binary = true; break;
+            case 'h': print_help(); return 1;
+            default: print_help(); return 1;
+        }
+    }
+    if( optind >= argc )
+    {
+        std::cerr << "invalid arguments\n";
+        print_help();
+        exit(1);
+    }
+
+    DFA_edge_list D;
+    if( family == "random" )
+    {
+        if( n == 0 || sigma == 0 || sigma > 255 ){ std::cerr << "invalid number of states or alphabet size\n"; exit(1); }
+        random_nearly_acyclic(n,sigma,indeg,(extra == U_MAX) ? n : extra,backward,seed,D);
+    }
+    else if( family == "chains" )
+    {
+        if( p == 0 || len == 0 || 2*p+len >= 256 ){ std::cerr << "invalid chains: 2p+len must be < 256\n"; exit(1); }
+        chains(p,len,D);
+    }
+    else if( family == "scaled" )
+    {
+        DFA_edge_list B;
+        read_dfa(base,B);
+        scaled(B,std::max(copies,1u),D);
+    }
+    else
+    {
+        std::cerr << "unknown family: " << family << "\n";
+        print_help();
+        exit(1);
+    }
+    if( binary ){ write_dfa_binary(std::string(argv[optind]),D); }
+    else{ write_dfa(std::string(argv[optind]),D); }
+
+    return 0;
+}
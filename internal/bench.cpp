@@ -0,0 +1,163 @@
+#include <unistd.h>
+#include "automaton.hpp"
+#include "utils.hpp"
+#include "hashing_function.hpp"
+// DFA minimization
+#include "minimize.hpp"
+// pruning and interval computation
+#include "intervals.hpp"
+// A^p construction and cycle detection
+#include "width.hpp"
+// synthetic DFA families
+#include "workloads.hpp"
+
+// benchmark input: a DFA and the p values to check
+struct workload
+{
+    std::string name;
+    DFA_edge_list D;
+    std::vector<uint> ps;
+};
+
+void print_help( void )
+{
+    std::cout << "usage: bench.x [options] [input.dfa ...]" << std::endl;
+    std::cout << "runs the built-in suite when no input DFA is given" << std::endl;
+    std::cout << " -d [dfa]   : base DFA of the scaled family (def. data/regexp.dfa)" << std::endl;
+    std::cout << " -p [p]     : p checked on the input DFAs (def. 2)" << std::endl;
+    std::cout << " -t [n]     : number of threads building A^p (def. 1)" << std::endl;
+    std::cout << " -s         : small suite, for a quick run" << std::endl;
+    std::cout << " -o [file]  : append the results to file (def. stdout)" << std::endl;
+}
+
+// built-in suite: random nearly-acyclic DFAs, disjoint chains and scaled copies of base.
+// Sizes are chosen so that the largest A^p fits in a few hundred MB
+void suite(std::string base, bool small, std::vector<workload>& W)
+{
+    auto add = [&](std::string name, std::vector<uint> ps) -> DFA_edge_list&
+    {
+        W.push_back(workload());
+        W.back().name = name;
+        W.back().ps = ps;
+        return W.back().D;
+    };
+
+    random_nearly_acyclic(250,4,2,250,false,1,add("random-n250-s4",{2,3}));
+    if( !small )
+        for(uint n: {1000,4000})
+            random_nearly_acyclic(n,4,2,n,false,1,add("random-n"+std::to_string(n)+"-s4",{2}));
+
+    for(uint p: small ? std::vector<uint>{2} : std::vector<uint>{2,4})
+        chains(p,50,add("chains-p"+std::to_string(p)+"-l50",{p,p+1}));
+
+    DFA_edge_list B;
+    read_dfa(base,B);
+    scaled(B,small ? 10 : 100,add("regexp-x"+std::to_string(small ? 10 : 100),{2,3}));
+    if( !small ){ scaled(B,1000,add("regexp-x1000",{2})); }
+}
+
+// time every stage of the det-width.x (full) and det-width-rm.x (rm) checks on w, one JSON line per p and mode
+void run(workload& w, uint threads, std::ostream& out)
+{
+    stopwatch sw, total;
+    DFA_edge_list D_min;
+    minimize_dfa(w.D,D_min);
+    double t_minimize = sw.elapsed();
+
+    sw.reset();
+    DFA_edge_list D_prmin, D_prmax;
+    prune_dfa(D_min,D_prmin,D_prmax);
+    double t_prune = sw.elapsed();
+
+    sw.reset();
+    std::vector< std::pair<uint,uint> > intervals;
+    compute_intervals(D_prmin,D_prmax,intervals);
+    double t_intervals = sw.elapsed();
+    D_prmin = DFA_edge_list(); D_prmax = DFA_edge_list();
+
+    min_dfa M(D_min);
+    double t_shared = total.elapsed();
+
+    for(uint p: w.ps)
+        for(std::string mode: {"full","rm","pairs"})
+        {
+            // the pair graph only answers p = 2
+            if( mode == "pairs" && p != 2 ){ continue; }
+            bool memory = (mode == "rm");
+            std::vector< std::pair<uint,uint> > I(intervals);
+            if( memory )
+                for(auto& i: I)
+                    if( i.first == i.second ){ i = std::make_pair(0,0); }
+
+            sw.reset();
+            width_checker C(M,I);
+            C.set_threads(threads);
+            double t_L = sw.elapsed();
+            bool cyclic = (p <= M.no_states()) &&
+                          (mode == "pairs" ? C.find_cycle_pairs() : memory ? C.find_cycle_sim(p) : C.find_cycle(p));
+            auto& s = C.stats();
+
+            out << "{\"workload\":\"" << w.name << "\",\"mode\":\"" << mode << "\""
+                << ",\"p\":" << p << ",\"threads\":" << threads
+                << ",\"dfa_states\":" << w.D.nodes << ",\"dfa_edges\":" << w.D.edges.size()
+                << ",\"min_states\":" << M.no_states() << ",\"min_edges\":" << M.no_edges()
+                << ",\"ap_states\":" << s.states << ",\"ap_edges\":" << s.edges
+                << ",\"width_lt_p\":" << (cyclic ? "false" : "true")
+                << ",\"time\":{\"minimize\":" << t_minimize << ",\"prune\":" << t_prune
+                << ",\"intervals\":" << t_intervals << ",\"L\":" << t_L
+                << ",\"ap_states\":" << s.states_time << ",\"ap_edges\":" << s.edges_time
+                << ",\"cycle\":" << s.cycle_time
+                << ",\"total\":" << t_shared+t_L+s.states_time+s.edges_time+s.cycle_time << "}}"
+                << std::endl;
+        }
+}
+
+int main(int argc, char** argv)
+{
+    int opt;
+    uint p = 2, threads = 1;
+    bool small = false;
+    std::string base = "data/regexp.dfa", out_file;
+    while( ( opt = getopt( argc, argv, "d:p:t:o:sh" ) ) != -1 )
+    {
+        switch( opt )
+        {
+            case 'd': base = std::string(optarg); break;
+            case 'p': p = read_uint<uint>(optarg); break;
+            case 't': threads = read_uint<uint>(optarg); break;
+            case 'o': out_file = std::string(optarg); break;
+            case 's': small = true; break;
+            case 'h': print_help(); return 1;
+            default: print_help(); return 1;
+        }
+    }
+    if( p < 2 )
+    {
+        std::cerr << "invalid arguments\n";
+        print_help();
+        exit(1);
+    }
+
+    std::vector<workload> W;
+    if( optind >= argc ){ suite(base,small,W); }
+    for(int i=optind;i<argc;++i)
+    {
+        workload w;
+        w.name = std::string(argv[i]);
+        read_dfa(w.name,w.D);
+        w.ps = {p};
+        W.push_back(std::move(w));
+    }
+
+    std::ofstream ofile;
+    if( out_file.size() > 0 ){ ofile.open(out_file,std::ios::app); }
+    std::ostream& out = (out_file.size() > 0) ? ofile : std::cout;
+    for(auto& w: W)
+    {
+        run(w,threads,out);
+        // free the input before the next workload
+        w.D = DFA_edge_list();
+    }
+
+    return 0;
+}
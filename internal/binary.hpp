@@ -0,0 +1,285 @@
+#ifndef BINARY_HPP_
+#define BINARY_HPP_
+
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "automaton.hpp"
+
+/*
+    binary files for DFAs, pruned graphs and intervals, read by mapping the file
+    in memory and using the arrays in place. A file starts with a 16 bytes header
+    (magic "DWBF", version, kind, 0), then
+    - DFA and pruned graph: nodes, edges, source and number of accepting states as
+      64 bit integers, followed by the arrays origin[edges], dest[edges] (32 bit),
+      label[edges] (8 bit) and accepting (32 bit);
+    - intervals: the number of states as a 64 bit integer, followed by the pairs
+      (infimum, supremum) as 32 bit integers.
+    Every array starts at a multiple of 8 bytes; integers are stored in the byte
+    order of the machine writing the file. The labels of a pruned graph are the
+    characters written by prune.x in the text format.
+*/
+
+const char bin_magic[4] = {'D','W','B','F'};
+const uint32_t bin_version = 1;
+
+enum bin_kind : uint32_t { BIN_DFA = 1, BIN_PRUNED = 2, BIN_INTERVALS = 3 };
+
+struct bin_header
+{
+    char magic[4];
+    uint32_t version;
+    uint32_t kind;
+    uint32_t reserved;
+};
+
+// bytes of n items of size b, rounded up to a multiple of 8
+inline size_t bin_padded(size_t n, size_t b){ return (n*b+7)/8*8; }
+
+// true if the file starts with the binary magic
+bool is_binary(std::string file)
+{
+    char m[4] = {0,0,0,0};
+    std::ifstream in(file, std::ios::binary);
+    in.read(m,4);
+    return in.gcount() == 4 && std::memcmp(m,bin_magic,4) == 0;
+}
+
+// read-only memory mapping of a whole file, unmapped by the destructor. A file that
+// cannot be mapped ends the program, unless exit_on_error is false: then is_open()
+// is false and the mapping is empty
+class mapped_file
+{
+public:
+    mapped_file(std::string file, bool exit_on_error = true)
+    {
+        int fd = open(file.c_str(),O_RDONLY);
+        struct stat st;
+        if( fd < 0 || fstat(fd,&st) != 0 )
+        {
+            if( fd >= 0 ){ close(fd); }
+            fail("cannot open " + file,exit_on_error);
+            return;
+        }
+        len = static_cast<size_t>(st.st_size);
+        ptr = (len > 0) ? mmap(nullptr,len,PROT_READ,MAP_PRIVATE,fd,0) : nullptr;
+        close(fd);
+        if( ptr == MAP_FAILED )
+        {
+            ptr = nullptr;
+            len = 0;
+            fail("cannot map " + file,exit_on_error);
+        }
+    }
+    ~mapped_file(){ if( ptr != nullptr ){ munmap(ptr,len); } }
+    mapped_file(const mapped_file&) = delete;
+    mapped_file& operator=(const mapped_file&) = delete;
+
+    bool is_open() const { return opened; }
+    const unsigned char* data() const { return static_cast<const unsigned char*>(ptr); }
+    size_t size() const { return len; }
+
+private:
+    void fail(const std::string& error, bool exit_on_error)
+    {
+        if( exit_on_error ){ std::cerr << error << "\n"; exit(1); }
+        opened = false;
+    }
+
+    void* ptr = nullptr;
+    size_t len = 0;
+    bool opened = true;
+};
+
+// DFA or pruned graph stored in a mapped file
+struct dfa_view
+{
+    uint64_t nodes = 0, edges = 0, source = 0, accepting = 0;
+    const uint32_t* origin = nullptr;
+    const uint32_t* dest = nullptr;
+    const unsigned char* label = nullptr;
+    const uint32_t* final_states = nullptr;
+};
+
+// intervals stored in a mapped file: the interval of state i is (iv[2i],iv[2i+1])
+struct interval_view
+{
+    uint64_t states = 0;
+    const uint32_t* iv = nullptr;
+};
+
+// read the header of a mapped file: false if it is too short, has no magic or has
+// another version, which is set in version (0 if unknown)
+bool bin_header_of(const mapped_file& f, uint32_t& kind, uint32_t& version)
+{
+    kind = version = 0;
+    if( f.size() < sizeof(bin_header) ){ return false; }
+    bin_header h;
+    std::memcpy(&h,f.data(),sizeof(h));
+    if( std::memcmp(h.magic,bin_magic,4) != 0 ){ return false; }
+    version = h.version;
+    kind = h.kind;
+    return h.version == bin_version;
+}
+
+// check the header of a mapped file and return its kind
+uint32_t bin_check(const mapped_file& f, std::string file)
+{
+    uint32_t kind, version;
+    if( !bin_header_of(f,kind,version) )
+    {
+        if( version == 0 ){ std::cerr << "invalid binary file " << file << "\n"; }
+        else{ std::cerr << "unsupported binary file " << file << " (version " << version << ")\n"; }
+        exit(1);
+    }
+    return kind;
+}
+
+// view of a mapped DFA (kind BIN_DFA) or pruned graph (kind BIN_PRUNED); false if the
+// header, the kind or the size of the file are wrong
+bool map_dfa(const mapped_file& f, dfa_view& v, uint32_t kind = BIN_DFA)
+{
+    v = dfa_view();
+    uint32_t k, version;
+    if( !bin_header_of(f,k,version) || k != kind || f.size() < sizeof(bin_header)+4*sizeof(uint64_t) ){ return false; }
+    const uint64_t* h = reinterpret_cast<const uint64_t*>(f.data()+sizeof(bin_header));
+    v.nodes = h[0]; v.edges = h[1]; v.source = h[2]; v.accepting = h[3];
+    size_t pos = sizeof(bin_header)+4*sizeof(uint64_t);
+    // bound the counts first, so that the expected size cannot overflow
+    if( v.edges > f.size() || v.accepting > f.size() ||
+        f.size() != pos+2*bin_padded(v.edges,4)+bin_padded(v.edges,1)+bin_padded(v.accepting,4) ){ return false; }
+    v.origin = reinterpret_cast<const uint32_t*>(f.data()+pos); pos += bin_padded(v.edges,4);
+    v.dest = reinterpret_cast<const uint32_t*>(f.data()+pos); pos += bin_padded(v.edges,4);
+    v.label = f.data()+pos; pos += bin_padded(v.edges,1);
+    v.final_states = reinterpret_cast<const uint32_t*>(f.data()+pos);
+    return true;
+}
+
+// as above, ending the program on a wrong file
+dfa_view map_dfa(const mapped_file& f, std::string file, uint32_t kind = BIN_DFA)
+{
+    bin_check(f,file);
+    dfa_view v;
+    if( !map_dfa(f,v,kind) )
+    {
+        std::cerr << "invalid binary " << (kind == BIN_DFA ? "DFA" : "pruned graph") << " in " << file << "\n";
+        exit(1);
+    }
+    return v;
+}
+
+// view of mapped intervals (kind BIN_INTERVALS); false if the header, the kind or the
+// size of the file are wrong
+bool map_interval(const mapped_file& f, interval_view& v)
+{
+    v = interval_view();
+    uint32_t k, version;
+    if( !bin_header_of(f,k,version) || k != BIN_INTERVALS || f.size() < sizeof(bin_header)+sizeof(uint64_t) ){ return false; }
+    v.states = *reinterpret_cast<const uint64_t*>(f.data()+sizeof(bin_header));
+    // bound the count first, so that the expected size cannot overflow
+    if( v.states > f.size() || f.size() != sizeof(bin_header)+sizeof(uint64_t)+bin_padded(2*v.states,4) ){ return false; }
+    v.iv = reinterpret_cast<const uint32_t*>(f.data()+sizeof(bin_header)+sizeof(uint64_t));
+    return true;
+}
+
+// as above, ending the program on a wrong file
+interval_view map_interval(const mapped_file& f, std::string file)
+{
+    bin_check(f,file);
+    interval_view v;
+    if( !map_interval(f,v) )
+    {
+        std::cerr << "invalid binary intervals in " << file << "\n";
+        exit(1);
+    }
+    return v;
+}
+
+// write the header and the first 64 bit fields of a binary file
+void bin_write_header(std::ofstream& out, uint32_t kind, std::initializer_list<uint64_t> fields)
+{
+    bin_header h;
+    std::memcpy(h.magic,bin_magic,4);
+    h.version = bin_version;
+    h.kind = kind;
+    h.reserved = 0;
+    out.write(reinterpret_cast<const char*>(&h),sizeof(h));
+    for(uint64_t x: fields){ out.write(reinterpret_cast<const char*>(&x),sizeof(x)); }
+}
+
+// write n items of size b from data, padded to a multiple of 8 bytes
+void bin_write_array(std::ofstream& out, const void* data, size_t n, size_t b)
+{
+    const char zero[8] = {0,0,0,0,0,0,0,0};
+    out.write(static_cast<const char*>(data),n*b);
+    out.write(zero,bin_padded(n,b)-n*b);
+}
+
+// write a DFA (or a pruned graph, with kind BIN_PRUNED) in the binary format
+void write_dfa_binary(std::string output_file, const DFA_edge_list& D, uint32_t kind = BIN_DFA)
+{
+    std::ofstream out(output_file, std::ios::binary);
+    bin_write_header(out,kind,{D.nodes,D.edges.size(),D.source,D.accepting.size()});
+    std::vector<uint32_t> a(D.edges.size());
+    for(size_t i=0;i<D.edges.size();++i){ a[i] = static_cast<uint32_t>(D.edges[i].origin); }
+    bin_write_array(out,a.data(),a.size(),4);
+    for(size_t i=0;i<D.edges.size();++i){ a[i] = static_cast<uint32_t>(D.edges[i].dest); }
+    bin_write_array(out,a.data(),a.size(),4);
+    std::vector<char> l(D.edges.size());
+    for(size_t i=0;i<D.edges.size();++i){ l[i] = D.edges[i].label; }
+    bin_write_array(out,l.data(),l.size(),1);
+    a.assign(D.accepting.begin(),D.accepting.end());
+    bin_write_array(out,a.data(),a.size(),4);
+    out.close();
+}
+
+// write the intervals in the binary format
+void write_interval_binary(std::string output_file, const std::vector< std::pair <uint,uint> >& intervals)
+{
+    std::ofstream out(output_file, std::ios::binary);
+    bin_write_header(out,BIN_INTERVALS,{intervals.size()});
+    std::vector<uint32_t> a;
+    a.reserve(2*intervals.size());
+    for(auto& i: intervals){ a.push_back(static_cast<uint32_t>(i.first)); a.push_back(static_cast<uint32_t>(i.second)); }
+    bin_write_array(out,a.data(),a.size(),4);
+    out.close();
+}
+
+// copy a mapped DFA or pruned graph into an edge list
+void load_dfa_view(const dfa_view& v, DFA_edge_list& D)
+{
+    D = DFA_edge_list();
+    D.nodes = static_cast<uint>(v.nodes);
+    D.source = static_cast<uint>(v.source);
+    D.edges.resize(v.edges);
+    for(size_t i=0;i<v.edges;++i){ D.edges[i] = {v.origin[i],char(v.label[i]),v.dest[i]}; }
+    D.accepting.assign(v.final_states,v.final_states+v.accepting);
+}
+
+// read a binary DFA file into D; false if it cannot be mapped or is not a valid
+// binary DFA (the program is not ended, e.g. for a batch of inputs)
+bool read_dfa_binary(std::string file, DFA_edge_list& D)
+{
+    mapped_file f(file,false);
+    dfa_view v;
+    if( !f.is_open() || !map_dfa(f,v) ){ return false; }
+    load_dfa_view(v,D);
+    return true;
+}
+
+// read a binary intervals file; false, leaving intervals empty, if it cannot be mapped
+// or is not a valid binary intervals file (the program is not ended)
+bool read_interval_binary(std::string file, std::vector< std::pair <uint,uint> >& intervals)
+{
+    intervals.clear();
+    mapped_file f(file,false);
+    interval_view v;
+    if( !f.is_open() || !map_interval(f,v) ){ return false; }
+    intervals.reserve(v.states);
+    for(size_t i=0;i<v.states;++i){ intervals.push_back(std::make_pair(v.iv[2*i],v.iv[2*i+1])); }
+    return true;
+}
+
+#endif
@@ -0,0 +1,236 @@
+#ifndef CACHE_HPP_
+#define CACHE_HPP_
+
+#include <cstdio>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "automaton.hpp"
+#include "utils.hpp"
+
+/*
+    persistent cache of the results on a minimum DFA. The key is a hash of its
+    canonical form, where the states are renumbered in BFS order from the source
+    visiting the transitions by label; the canonical DFA is stored with the entry
+    and compared on lookup, so hash collisions are harmless. An entry keeps the
+    known bounds on the width and the intervals of the canonical DFA. Files are
+    written to a temporary name and renamed, so concurrent processes sharing the
+    directory never read a partial file; concurrent updates of the same bounds
+    may lose one of them.
+*/
+
+// canonical form C of the minimum DFA D; unreachable states, if any, follow in their
+// order. If ids is given, (*ids)[v] is the state of C renumbering state v of D
+void canonical_dfa(const DFA_edge_list& D, DFA_edge_list& C, std::vector<uint>* ids = nullptr)
+{
+    // transitions by origin, sorted by label
+    std::vector<size_t> off(size_t(D.nodes)+1,0);
+    for(auto& e: D.edges){ off[e.origin+1]++; }
+    for(uint i=0;i<D.nodes;++i){ off[i+1] += off[i]; }
+    std::vector<size_t> by_origin(D.edges.size()), pos(off.begin(),off.end()-1);
+    for(size_t i=0;i<D.edges.size();++i){ by_origin[pos[D.edges[i].origin]++] = i; }
+    auto label = [&](size_t i){ return static_cast<unsigned char>(D.edges[i].label); };
+    for(uint i=0;i<D.nodes;++i)
+        std::sort(by_origin.begin()+off[i],by_origin.begin()+off[i+1],[&](size_t a, size_t b){ return label(a) < label(b); });
+
+    // BFS order from the source
+    std::vector<uint> id(D.nodes,U_MAX), order;
+    order.reserve(D.nodes);
+    if( D.nodes > 0 ){ id[D.source] = 0; order.push_back(D.source); }
+    for(size_t k=0;k<order.size();++k)
+        for(size_t j=off[order[k]];j<off[order[k]+1];++j)
+        {
+            uint d = D.edges[by_origin[j]].dest;
+            if( id[d] == U_MAX ){ id[d] = static_cast<uint>(order.size()); order.push_back(d); }
+        }
+    for(uint v=0;v<D.nodes;++v)
+        if( id[v] == U_MAX ){ id[v] = static_cast<uint>(order.size()); order.push_back(v); }
+
+    C = DFA_edge_list();
+    C.nodes = D.nodes;
+    C.source = 0;
+    C.edges.reserve(D.edges.size());
+    for(uint v: order)
+        for(size_t j=off[v];j<off[v+1];++j)
+        {
+            const transition& e = D.edges[by_origin[j]];
+            C.add_edge(id[v],e.label,id[e.dest]);
+        }
+    for(auto f: D.accepting){ C.accepting.push_back(id[f]); }
+    std::sort(C.accepting.begin(),C.accepting.end());
+    if( ids != nullptr ){ ids->swap(id); }
+}
+
+// 64-bit FNV-1a hash of a canonical DFA
+uint64_t dfa_hash(const DFA_edge_list& C)
+{
+    uint64_t h = 14695981039346656037ULL;
+    auto add = [&](uint64_t x)
+    {
+        for(uint i=0;i<8;++i){ h ^= (x >> (8*i)) & 0xff; h *= 1099511628211ULL; }
+    };
+    add(C.nodes); add(C.source); add(C.edges.size());
+    for(auto& e: C.edges){ add(e.origin); add(static_cast<unsigned char>(e.label)); add(e.dest); }
+    add(C.accepting.size());
+    for(auto f: C.accepting){ add(f); }
+    return h;
+}
+
+// known bounds on the width: lo <= width <= hi
+struct width_bounds
+{
+    uint lo = 1, hi = U_MAX;
+
+    // answer of the query width < p: 1 if true, 0 if false, -1 if unknown
+    int answer(uint p) const { return (p > hi) ? 1 : (p <= lo) ? 0 : -1; }
+    bool exact() const { return lo == hi; }
+
+    // record the answer of a p query (cyclic: A^p has a cycle) or an exact width
+    void add(uint p, bool cyclic)
+    {
+        if( cyclic ){ lo = std::max(lo,p); }
+        else{ hi = std::min(hi,p-1); }
+    }
+    void set_exact(uint w){ lo = hi = w; }
+};
+
+class result_cache
+{
+public:
+    // cache in directory dir, created if needed
+    result_cache(std::string dir_) : dir(dir_)
+    {
+        mkdir(dir.c_str(),0777);
+        struct stat st;
+        if( stat(dir.c_str(),&st) != 0 || !S_ISDIR(st.st_mode) )
+        {
+            std::cerr << "cannot create the cache directory " << dir << "\n";
+            exit(1);
+        }
+    }
+
+    /*
+        look up the canonical DFA C: returns true if it has an entry, setting the
+        bounds on its width (initially [1,states]) and, if intervals is given and
+        they are stored, the intervals (false otherwise). An entry that cannot be
+        read, e.g. truncated by a crash or written by another version, is a miss
+    */
+    bool lookup(const DFA_edge_list& C, width_bounds& b, std::vector< std::pair<uint,uint> >* intervals = nullptr,
+                bool* have_intervals = nullptr)
+    {
+        b = width_bounds();
+        b.hi = std::max<uint>(C.nodes,1);
+        if( have_intervals != nullptr ){ *have_intervals = false; }
+        std::string base = key(C);
+        if( access((base+".dfa").c_str(),R_OK) != 0 ){ return false; }
+        DFA_edge_list E;
+        if( !read_dfa_binary(base+".dfa",E) || !same_dfa(C,E) ){ return false; }
+
+        std::vector< std::pair<uint,uint> > iv;
+        if( intervals != nullptr && access((base+".interval").c_str(),R_OK) == 0 )
+        {
+            if( !read_interval_binary(base+".interval",iv) || iv.size() != C.nodes ){ return false; }
+        }
+
+        std::ifstream in(base+".width");
+        width_bounds s;
+        if( in >> s.lo >> s.hi && s.lo <= s.hi ){ b.lo = std::max(b.lo,s.lo); b.hi = std::min(b.hi,s.hi); }
+        if( iv.size() > 0 )
+        {
+            intervals->swap(iv);
+            if( have_intervals != nullptr ){ *have_intervals = true; }
+        }
+        return true;
+    }
+
+    /*
+        create the entry of C, if missing, with the bounds and the intervals if
+        given; false if the key is taken by another DFA (a hash collision), in
+        which case C is not cached. Files of the entry that cannot be read are
+        replaced
+    */
+    bool store(const DFA_edge_list& C, const width_bounds& b, const std::vector< std::pair<uint,uint> >* intervals = nullptr)
+    {
+        std::string base = key(C);
+        width_bounds old;
+        if( !lookup(C,old) )
+        {
+            DFA_edge_list E;
+            if( read_dfa_binary(base+".dfa",E) ){ return false; }
+            // the files left by an unreadable entry may belong to another DFA
+            unlink((base+".width").c_str());
+            unlink((base+".interval").c_str());
+            std::string tmp = temporary();
+            write_dfa_binary(tmp,C);
+            publish(tmp,base+".dfa");
+        }
+        std::vector< std::pair<uint,uint> > iv;
+        if( intervals != nullptr && (!read_interval_binary(base+".interval",iv) || iv.size() != C.nodes) )
+        {
+            std::string tmp = temporary();
+            write_interval_binary(tmp,*intervals);
+            publish(tmp,base+".interval");
+        }
+        store_bounds(base,b);
+        return true;
+    }
+
+    // merge b into the bounds of the entry with the given key, created by store
+    void store_bounds(const std::string& base, width_bounds b)
+    {
+        std::ifstream in(base+".width");
+        width_bounds old;
+        // keep the stored bounds unless they contradict the new ones
+        if( in >> old.lo >> old.hi && std::max(b.lo,old.lo) <= std::min(b.hi,old.hi) )
+        {
+            b.lo = std::max(b.lo,old.lo);
+            b.hi = std::min(b.hi,old.hi);
+        }
+        in.close();
+        std::string tmp = temporary();
+        {
+            std::ofstream out(tmp);
+            out << b.lo << " " << b.hi << "\n";
+        }
+        publish(tmp,base+".width");
+    }
+
+    // key of the entry of C: its path without the extension
+    std::string key(const DFA_edge_list& C) const
+    {
+        char h[17];
+        std::snprintf(h,sizeof(h),"%016llx",static_cast<unsigned long long>(dfa_hash(C)));
+        return dir + "/" + h;
+    }
+
+    // true if the DFAs have the same states, transitions (in order) and accepting states
+    static bool same_dfa(const DFA_edge_list& A, const DFA_edge_list& B)
+    {
+        if( A.nodes != B.nodes || A.source != B.source || A.edges.size() != B.edges.size() || A.accepting != B.accepting )
+            return false;
+        for(size_t i=0;i<A.edges.size();++i)
+            if( A.edges[i].origin != B.edges[i].origin || A.edges[i].label != B.edges[i].label || A.edges[i].dest != B.edges[i].dest )
+                return false;
+        return true;
+    }
+
+private:
+
+    // new empty file in the cache directory
+    std::string temporary() const
+    {
+        std::string name = dir + "/.tmp-XXXXXX";
+        int fd = mkstemp(&name[0]);
+        if( fd < 0 ){ std::cerr << "cannot write to the cache directory " << dir << "\n"; exit(1); }
+        close(fd);
+        return name;
+    }
+
+    static void publish(const std::string& tmp, const std::string& file)
+    {
+        if( std::rename(tmp.c_str(),file.c_str()) != 0 ){ std::remove(tmp.c_str()); }
+    }
+
+    std::string dir;
+};
+
+#endif
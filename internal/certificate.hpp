@@ -0,0 +1,134 @@
+#ifndef CERTIFICATE_HPP_
+#define CERTIFICATE_HPP_
+
+#include <algorithm>
+#include <functional>
+#include "automaton.hpp"
+#include "utils.hpp"
+// pruning and interval computation
+#include "intervals.hpp"
+
+/*
+    certificates of the width answers, for co-lex indexes built downstream. A
+    width >= p answer is certified by a cycle of A^p and a width < p answer by a
+    topological order of the acyclic A^p (see width_checker::write_witness and
+    width_checker::write_order); the exact width w is certified by both, on A^w
+    and A^(w+1).
+
+    This file computes the order to index with, which certifies nothing: the one
+    of the intervals on the input-consistent DFA equivalent to the minimum one.
+    Every state is split by the label of its incoming transitions, state q
+    entered by label a becoming the pair (q,a), and the source also has the pair
+    (source,empty string). Two pairs are ordered if the interval of the first
+    ends by the beginning of the second, as on the L lists, so a chain is checked
+    by comparing the intervals of consecutive pairs. The number of chains is the
+    co-lex width of the split DFA: an upper bound on the width of the language,
+    usually well above it, since the DFAs of smallest width split the states
+    further.
+*/
+
+// incoming label of a pair (state, label) made of the source and the empty string
+const uint empty_label = U_MAX;
+
+/*
+    minimum partition of the states into chains of the order of their intervals:
+    u precedes v if u ends by the beginning of v. The states are visited by
+    beginning and each one extends the chain ending first, if it ends by its
+    beginning; intervals form an interval order, so the number of chains equals
+    the largest number of pairwise overlapping intervals. Every chain lists its
+    states in order.
+*/
+uint interval_chains(const std::vector< std::pair<uint,uint> >& intervals, std::vector< std::vector<uint> >& chains)
+{
+    std::vector<uint> order(intervals.size());
+    for(uint i=0;i<order.size();++i){ order[i] = i; }
+    std::sort(order.begin(),order.end(),[&](uint a, uint b){ return intervals[a] < intervals[b]; });
+
+    // open chains as (end of the last interval, chain), the first ending on top
+    std::vector< std::pair<uint,uint> > ends;
+    chains.clear();
+    for(auto s: order)
+    {
+        uint c = static_cast<uint>(chains.size());
+        if( !ends.empty() && ends.front().first <= intervals[s].first )
+        {
+            c = ends.front().second;
+            std::pop_heap(ends.begin(),ends.end(),std::greater< std::pair<uint,uint> >());
+            ends.pop_back();
+        }
+        else{ chains.push_back(std::vector<uint>()); }
+        chains[c].push_back(s);
+        ends.push_back({intervals[s].second,c});
+        std::push_heap(ends.begin(),ends.end(),std::greater< std::pair<uint,uint> >());
+    }
+    return static_cast<uint>(chains.size());
+}
+
+/*
+    co-lex chains of the input-consistent DFA splitting the states of M by
+    incoming label (see above): chains of pairs (state, label), the label being
+    the unsigned code of the label in the DFA files or empty_label. Returns the
+    number of chains.
+*/
+uint colex_chains(const min_dfa& M, uint source, std::vector< std::vector< std::pair<uint,uint> > >& chains)
+{
+    // pairs sorted by state, then by label code (0: empty string, as in compute_intervals)
+    std::vector< std::pair<uint,uint> > pairs;
+    pairs.reserve(size_t(M.no_edges())+1);
+    if( source < M.no_states() ){ pairs.push_back({source,0}); }
+    for(uint s=0;s<M.no_states();++s)
+        for(uint e=M.first(s);e<M.last(s);++e)
+            pairs.push_back({M.dest_at(e),label_code(M.label_at(e))});
+    std::sort(pairs.begin(),pairs.end());
+    pairs.erase(std::unique(pairs.begin(),pairs.end()),pairs.end());
+    auto id = [&](uint s, uint c)
+    {
+        return static_cast<uint>(std::lower_bound(pairs.begin(),pairs.end(),std::make_pair(s,c)) - pairs.begin());
+    };
+
+    // the split DFA: pair (q,c) has the transitions of q, entering the pairs of their labels
+    DFA_edge_list S;
+    S.nodes = static_cast<uint>(pairs.size());
+    S.source = (source < M.no_states()) ? id(source,0) : 0;
+    for(uint i=0;i<S.nodes;++i)
+    {
+        uint q = pairs[i].first;
+        for(uint e=M.first(q);e<M.last(q);++e)
+            S.add_edge(i,M.label_at(e),id(M.dest_at(e),label_code(M.label_at(e))));
+    }
+
+    DFA_edge_list S_prmin, S_prmax;
+    std::vector< std::pair<uint,uint> > intervals;
+    prune_dfa(S,S_prmin,S_prmax);
+    S.edges.clear();
+    S.edges.shrink_to_fit();
+    compute_intervals(S_prmin,S_prmax,intervals);
+
+    std::vector< std::vector<uint> > ids;
+    interval_chains(intervals,ids);
+    chains.assign(ids.size(),std::vector< std::pair<uint,uint> >());
+    for(size_t c=0;c<ids.size();++c)
+        for(auto i: ids[c])
+            chains[c].push_back({pairs[i].first,(pairs[i].second > 0) ? pairs[i].second-1 : empty_label});
+    return static_cast<uint>(chains.size());
+}
+
+/*
+    write the chains of colex_chains: "colex c", then one chain per line as
+    state:label pairs, state:- for the source entered by the empty string
+*/
+void write_chains(std::ostream& out, const std::vector< std::vector< std::pair<uint,uint> > >& chains)
+{
+    out << "colex " << chains.size() << "\n";
+    for(auto& c: chains)
+    {
+        for(size_t i=0;i<c.size();++i)
+        {
+            out << (i > 0 ? " " : "") << c[i].first << ":";
+            if( c[i].second == empty_label ){ out << "-"; } else { out << c[i].second; }
+        }
+        out << "\n";
+    }
+}
+
+#endif
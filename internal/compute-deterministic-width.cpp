@@ -1,303 +1,161 @@
 // include DFA automaton implementation
+#include <unistd.h>
 #include "automaton.hpp"
 #include "hashing_function.hpp"
 #include "utils.hpp"
-
-typedef DFA_unidirectional_out_labelled<std::unordered_set<uint>> DFA; // DFA type
-
-// global variables for recursive function
-std::vector<uint>* v; // pointer to vector containing all states with the same outgoing label
-char label; // label
-std::vector< std::pair<uint,uint> > intervals; // intervals vector
-DFA A = DFA();
-DFA M = DFA();
-uint p;
-
-// DFS function to find if a cycle exists
-bool isCyclic(uint c, bool visited[], bool* recStack)
-{
-    if (visited[c] == false)
-    {
-        // mark state as visited
-        visited[c] = true;
-        recStack[c] = true;
-
-        // visit all adjacent states
-        for (auto& i: A.at(c)->out)
-        {
-            if (!visited[i.second] && isCyclic(i.second, visited, recStack))
-            {
-                return true;
-            }
-            else if (recStack[i.second])
-            {
-                return true;
-            }
-        }
-    }
-
-    // remove the state from recursion stack
-    recStack[c] = false;
-    return false;
-}
-
-bool DFS_cycle_detection()
+// include A^p construction and cycle detection
+#include "width.hpp"
+// include width certificates
+#include "certificate.hpp"
+
+// write the certificate of a width < q answer: a topological order of A^q, which has no
+// states without a checker W (q exceeds the states of M), then the co-lex chains of M
+// from its source as an order to index with
+void certify_order(std::ostream& out, const min_dfa& M, uint source, width_checker* W, uint q)
 {
-    // mark all states as not visited
-    uint V = A.no_nodes();
-    bool* visited = new bool[V];
-    bool* recStack = new bool[V];
-    for (uint i = 0; i < V; ++i) {
-        visited[i] = false;
-        recStack[i] = false;
-    }
-
-    // recursive function call
-    for (uint i = 0; i < V; ++i)
-    {
-        if (!visited[i] && isCyclic(i, visited, recStack))
-        {
-            return true;
-        }
-    }
- 
-    return false;
+    if( W == nullptr ){ out << "order " << q << " 0\n"; }
+    else{ W->write_order(out,q); }
+    std::vector< std::vector< std::pair<uint,uint> > > chains;
+    colex_chains(M,source,chains);
+    write_chains(out,chains);
 }
 
-// recursive p level for loop
-void recursive_construction( uint rightLim, uint l ) 
+int main(int argc, char** argv)
 {
-    // static vector for loop indexes
-    static std::vector<uint> indexes(p,0);
-    // set representing states in the pruned automaton
-    static std::unordered_set<uint> state;
-    // simulate the lth nested cycle
-    if( l < p )
-    {
-        for(uint i=indexes[l-1]+1;i<=(*v).size()-(p-l);++i)
-        {
-            // check if the current state overlap with the previous one
-            if( rightLim <= intervals[(*v)[i-1]].first )
-                break;
-            // set new index for level l and recurse
-            indexes[l] = i;
-            recursive_construction(std::min(rightLim,intervals[(*v)[i-1]].second),l+1);
-        }
-    }
-    else
+    // initialize necessary data structures
+    std::vector< std::pair<uint,uint> > intervals; // intervals vector
+    min_dfa M;
+    // source of the minimum DFA, read from its file
+    uint source = 0;
+    uint p = 0;
+    // compute the exact width instead of checking p
+    bool exact = false;
+    // on-the-fly A^p cycle detection
+    bool lazy = false;
+    // threads building A^p and running the parallel cycle detection
+    uint threads = 1;
+    // print a cycle of A^p when found
+    bool witness = false;
+    // cycle detection algorithm
+    cycle_algorithm algo = DFS_CYCLE;
+    // JSON file of the per-phase statistics
+    std::string stats_file;
+    // certificate of the answer: a cycle of A^p or a topological order of the acyclic A^p
+    std::string cert_file;
+    int opt;
+    while( ( opt = getopt( argc, argv, "elwa:t:s:C:" ) ) != -1 )
     {
-        // last recursion level
-        for(uint j=indexes[l-1]+1;j<=(*v).size();++j)
+        switch( opt )
         {
-            // check if the current state overlap with the previous one
-            if( rightLim <= intervals[(*v)[j-1]].first )
+            case 'e': exact = true; break;
+            case 'l': lazy = true; break;
+            case 'w': witness = true; break;
+            case 't': threads = read_uint<uint>(optarg); break;
+            case 's': stats_file = std::string(optarg); break;
+            case 'C': cert_file = std::string(optarg); break;
+            case 'a':
+                if( !parse_cycle_algorithm(optarg,algo) )
+                {
+                    std::cerr << "unknown cycle detection algorithm: " << optarg << " (dfs, kahn, par)\n";
+                    exit(1);
+                }
                 break;
-            // empty set
-            state.clear();
-            // add an set containing p overlapping states
-            // and fill state vector
-            for(uint i=1;i<p;++i)
-                state.insert((*v)[indexes[i]-1]);
-            // insert the last element in set
-            state.insert((*v)[j-1]);
-            // add the empty state to the pruned automaton
-            A.add_state(state,label);
+            default: break;
         }
     }
-}
-   
-int main(int argc, char** argv)
-{
-    // initialize necessary data structures
-    std::unordered_map<char,std::vector<uint>> L;
-    //std::vector< std::pair <uint,uint> > intervals;
-    std::vector<uint> order;
     
-    if(argc > 3)
+    if(argc - optind > (exact ? 1 : 2))
     { 
         // set input arguments
         std::string in_dfa, in_interval;
-        p = read_uint<uint>(argv[1]);
-        in_dfa = std::string(argv[2]);
-        in_interval = std::string(argv[3]);
+        if( !exact ){ p = read_uint<uint>(argv[optind++]); }
+        in_dfa = std::string(argv[optind]);
+        in_interval = std::string(argv[optind+1]);
+        std::unique_ptr<run_stats> rs;
+        if( stats_file.size() > 0 ){ rs.reset(new run_stats("det-width.x")); }
+        auto phase = [&](const char* name){ if( rs ){ rs->begin(name); } };
 
         // read intervals file
-        uint max_beg = read_interval(in_interval,intervals,false);
-        uint n = static_cast<uint>(intervals.size());
-
-        #ifdef VERBOSE
-        {
-            std::cout << "### sorting intervals ###\n";
-            std::cout << "-> number of intervals: " << n << "\n";
-        }
-        #endif
-
-        // sort the intervals and store their ordering in order
-        order.resize(n);
-        counting_sort(intervals, order, max_beg+1);
-
-        #ifdef VERBOSE
-        {
-            // print intervals
-            for(uint i=0;i<intervals.size();++i)
-            {
-                std::cout << intervals[order[i]].first << " - " << intervals[order[i]].second << " : " << order[i] << "\n";
-            }
-            std::cout << "### compute A^" << p << " pruned automaton ###\n";
-        }
-        #endif
+        phase("read_intervals");
+        read_interval(in_interval,intervals,false);
         
         // stop if p is greater than the number of states in the minimum DFA
-        if( p > intervals.size() )
+        if( !exact && p > intervals.size() )
         {
             std::cout << "The tested width is greater than the number of states in the minimum DFA\n";
-            exit(0);
-        }
-
-        // read minimized DFA
-        read_min_dfa(in_dfa,M); 
-
-        // create L data structure
-        for(uint x=0;x<n;++x)
-        { 
-            uint i = order[x];
-            for (auto& j: M.at(i)->out)
+            if( rs ){ rs->set("p",p); rs->set("width_lt_p","true"); rs->write(stats_file); }
+            if( cert_file.size() > 0 )
             {
-                if(L.find(j.first) != L.end())
-                {
-                    L[j.first].push_back(i);
-                }
-                else{ L[j.first] = std::vector<uint>{ i }; }
+                std::ofstream cert(cert_file);
+                read_min_dfa(in_dfa,M,&source);
+                cert << "width < " << p << "\n";
+                certify_order(cert,M,source,nullptr,p);
             }
+            exit(0);
         }
-        // free order vector
-        order.clear();
 
-        #ifdef VERBOSE
-        {
-            std::cout << "-> L data structure\n";
-            // print L data structure
-            for (auto& j: L)
-            {
-                std::cout << j.first << " : ";
-                for(uint i=0;i<j.second.size();++i)
-                {
-                    std::cout << j.second[i] << " ";
-                }
-                std::cout << std::endl;
-            }
-            std::cout << "-> States in the A^" << p << " pruned automaton\n";
-        }
-        #endif
+        // read minimized DFA
+        phase("read_dfa");
+        read_min_dfa(in_dfa,M,&source); 
+        if( rs ){ rs->count("states",M.no_states()); rs->count("edges",M.no_edges()); }
 
-        // construct the A^p pruned automaton
-        for (auto& j: L)
-        {
-            if( j.second.size() < p )  
-                continue;
-            v = &j.second;
-            label = j.first;
-            // indexes of the p nested loops
-            recursive_construction(U_MAX,1);
-        }
-        // clear intervals vector
-        intervals.clear();
+        // sort the intervals and create L data structure
+        width_checker W(M,intervals,rs.get());
+        W.set_cycle_algorithm(algo);
+        W.set_threads(threads);
+        W.set_witness(witness || cert_file.size() > 0);
 
-        #ifdef VERBOSE
-        {
-            uint node_count = 0;
-            for (auto& m: *A.give_mapping())
-            {
-                std::cout << node_count++ << ": (";
-                for(auto i = m.first.begin(); i != m.first.end(); ++i)
-                {
-                    if( i != m.first.begin() ){ std::cout << " "; }
-                    std::cout << *i;
-                }
-                std::cout << ") labels: (";
-                auto entry = A.at(m.second);
-                for(uint i=0;i<entry->labels.size();++i)
-                {
-                    if( i > 0 ){ std::cout << " "; }
-                    std::cout << entry->labels[i];
-                }
-                std::cout << ")\n";
-            }
-            std::cout << "Number of states: " << A.no_nodes() << "\n";
-            std::cout << "-> Edges in the A^" << p <<" pruned automaton\n";
-        }
-        #endif
-
-        // compute edges in the A^p squared automaton
-        for (auto& m: *A.give_mapping())
+        // open output file
+        std::ofstream ofile;
+        ofile.open("answer");
+        std::ofstream cert;
+        if( cert_file.size() > 0 ){ cert.open(cert_file); }
+        if( exact )
         {
-            // compute all edges for each label separaterly
-            for (auto& j: A.at(m.second)->labels)
+            uint width = W.exact_width(false);
+            std::cout << "The language width is " << width << ".\n";
+            ofile << width;
+            if( rs ){ rs->set("width",width); }
+            if( cert.is_open() )
             {
-                // compute reached state
-                //std::vector<uint> state(p,0);
-                std::unordered_set<uint> state;
-                //for(uint i=0;i<m.first.size();++i)
-                for (const auto& e: m.first)
-                    state.insert(M.at(e)->out[j]);
-                    //state[i] = M.at(m.first[i])->out[j];
-
-                // check if state is present
-                auto entry = A.give_mapping()->find(state);
-                if( entry != A.give_mapping()->end() )
-                {
-                    #ifdef VERBOSE
-                        std::cout << "(";
-                        for(auto i = m.first.begin(); i != m.first.end(); ++i)
-                        {
-                            if( i != m.first.begin() )
-                                std::cout << " ";
-                            std::cout << *i;
-                        }
-                        std::cout << ") ->(" << j << ") (";
-                        for(auto i = state.begin(); i != state.end(); ++i)
-                        {
-                            if( i != state.begin() ){ std::cout << " "; }
-                            std::cout << *i;
-                        }
-                        std::cout << ")\n";
-                    #endif
-                    // add an edge if the reached state has at least
-                    // one outgoing edge.
-                    A.add_edge(m.second,j,entry->second);
-                }
+                cert << "width = " << width << "\n";
+                if( width >= 2 && !W.witness().empty() ){ W.write_witness(cert); }
+                certify_order(cert,M,source,&W,width+1);
             }
-            // empty labels vector
-            A.clear_labels(m.second);
         }
-
-        // check if the A^p automaton has cycles
-        #ifdef VERBOSE
-        {
-            std::cout << "Number of edges: " << A.no_edges() << "\n";
-            std::cout << "### check A^" << p << " automaton cyclicity ###\n";
-        }
-        #endif
-
-        // open output file
-        std::ofstream ofile;
-        ofile.open("answer");
-        if( DFS_cycle_detection() )
+        else if( lazy ? W.find_cycle_lazy(p) : (p == 2) ? W.find_cycle_pairs() : W.find_cycle(p) )
         {
             std::cout << p << "-cycle found! The language width is >=(greater or equal than) " << p << ".\n";
+            if( witness ){ W.print_witness(std::cout); }
             ofile << 0;
+            if( rs ){ rs->set("p",p); rs->set("width_lt_p","false"); }
+            if( cert.is_open() ){ cert << "width >= " << p << "\n"; W.write_witness(cert); }
         }
         else
         {
             std::cout << "No " << p << "-cycle found! The language width is <(smaller than) " << p << ".\n";
             ofile << 1;
+            if( rs ){ rs->set("p",p); rs->set("width_lt_p","true"); }
+            if( cert.is_open() )
+            {
+                cert << "width < " << p << "\n";
+                certify_order(cert,M,source,&W,p);
+            }
         }
         ofile.close();
+        if( rs ){ rs->write(stats_file); }
     }
     else
     {
         std::cerr << "invalid no. arguments\n";
         std::cerr << "Format your command as follows: .\\p recognizer minimum_dfa dfa_intervals\n";
+        std::cerr << "or, to compute the exact width: -e minimum_dfa dfa_intervals\n";
+        std::cerr << "-a dfs|kahn|par selects the cycle detection algorithm (def. dfs; par runs on -t threads)\n";
+        std::cerr << "-w prints a cycle of A^p when one is found\n";
+        std::cerr << "-C file writes a certificate of the answer: a cycle of A^p, or a topological order of A^p and co-lex chains\n";
+        std::cerr << "-l explores A^p on the fly and stops at the first cycle\n";
+        std::cerr << "-t threads builds A^p on the given number of threads (def. 1)\n";
+        std::cerr << "-s file writes the time, peak memory and counters of every phase to file (JSON)\n";
         exit(1);
     }
 
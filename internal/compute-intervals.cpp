@@ -0,0 +1,79 @@
+#include <unistd.h>
+#include "automaton.hpp"
+#include "utils.hpp"
+// pruning and interval computation
+#include "intervals.hpp"
+// external memory pruning and interval computation
+#include "intervals_external.hpp"
+
+void print_help( void )
+{
+    std::cout << "usage: intervals.x [options] input.dfa output.interval" << std::endl;
+    std::cout << "computes the co-lex intervals of the states of a DFA (the minimum DFA in the pipeline)" << std::endl;
+    std::cout << " -M [MB]  : external memory mode within the given memory budget" << std::endl;
+    std::cout << " -T [dir] : directory of the temporary files (def. $TMPDIR or /tmp)" << std::endl;
+    std::cout << " -b       : write the intervals in the binary format" << std::endl;
+}
+
+int main(int argc, char** argv)
+{
+    int opt;
+    bool external = false, binary = false;
+    size_t budget = 0;
+    std::string tmp_dir;
+    while( ( opt = getopt( argc, argv, "M:T:bh" ) ) != -1 )
+    {
+        switch( opt )
+        {
+            case 'M': external = true; budget = read_uint<size_t>(optarg) << 20; break;
+            case 'T': tmp_dir = std::string(optarg); break;
+            case 'b': binary = true; break;
+            case 'h': print_help(); return 1;
+            default: print_help(); return 1;
+        }
+    }
+    if( argc - optind < 2 )
+    {
+        std::cerr << "invalid arguments\n";
+        print_help();
+        exit(1);
+    }
+    std::string in_dfa = std::string(argv[optind]), out_interval = std::string(argv[optind+1]);
+
+    if( !external )
+    {
+        DFA_edge_list D, D_prmin, D_prmax;
+        std::vector< std::pair<uint,uint> > intervals;
+        read_dfa(in_dfa,D);
+        prune_dfa(D,D_prmin,D_prmax);
+        D = DFA_edge_list();
+        compute_intervals(D_prmin,D_prmax,intervals);
+        if( binary ){ write_interval_binary(out_interval,intervals); }
+        else{ write_interval(out_interval,intervals); }
+        return 0;
+    }
+
+    // the intervals are written as they are computed; the binary header needs the
+    // number of states, which is rewritten at the end
+    std::ofstream out(out_interval, binary ? std::ios::binary : std::ios::out);
+    if( binary ){ bin_write_header(out,BIN_INTERVALS,{0}); }
+    uint64_t states = 0;
+    compute_intervals_external(in_dfa,ext_config(tmp_dir,budget),[&](uint, uint inf, uint sup)
+    {
+        if( binary )
+        {
+            uint32_t iv[2] = {static_cast<uint32_t>(inf),static_cast<uint32_t>(sup)};
+            out.write(reinterpret_cast<const char*>(iv),sizeof(iv));
+        }
+        else{ out << inf << "\t" << sup << "\n"; }
+        states++;
+    });
+    if( binary )
+    {
+        out.seekp(sizeof(bin_header));
+        out.write(reinterpret_cast<const char*>(&states),sizeof(states));
+    }
+    out.close();
+
+    return 0;
+}
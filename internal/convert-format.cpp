@@ -0,0 +1,105 @@
+#include <unistd.h>
+#include "automaton.hpp"
+#include "utils.hpp"
+
+// parser for a pruned graph in the text format of prune.x: origin destination label
+// per line, then the header nodes edges source accepting
+void read_pruned_text(std::string input_file, DFA_edge_list& G)
+{
+    text_reader input(input_file);
+    uint64_t x[4];
+    char first[4];
+    size_t fields;
+    G = DFA_edge_list();
+    while( (fields = input.read_line(x,4,first)) != text_reader::U_EOF )
+    {
+        if( fields == 3 ){ G.add_edge(static_cast<uint>(x[0]),first[2],static_cast<uint>(x[1])); }
+        else if( fields == 4 )
+        {
+            G.nodes = static_cast<uint>(x[0]);
+            G.source = static_cast<uint>(x[2]);
+            // the text format keeps the number of accepting states only
+            G.accepting.assign(x[3],0);
+        }
+        else if( fields > 0 )
+        {
+            std::cerr << "invalid pruned graph line in " << input_file << "\n";
+            exit(1);
+        }
+    }
+}
+
+// write a pruned graph in the text format of prune.x (labels are written as stored)
+void write_pruned_text(std::string output_file, const DFA_edge_list& G)
+{
+    std::ofstream output(output_file);
+    for(auto& e: G.edges)
+        output << e.origin << " " << e.dest << " " << e.label << "\n";
+    output << G.nodes << " " << G.edges.size() << " " << G.source << " " << G.accepting.size() << "\n";
+    output.close();
+}
+
+void print_help( void )
+{
+    std::cout << "usage: convert.x [options] input output" << std::endl;
+    std::cout << "converts a text file to the binary format and a binary file to the text format" << std::endl;
+    std::cout << " -k [kind] : kind of a text input, dfa, pruned (prune.x output) or intervals (def. dfa)" << std::endl;
+}
+
+int main(int argc, char** argv)
+{
+    int opt;
+    std::string kind = "dfa";
+    while( ( opt = getopt( argc, argv, "k:h" ) ) != -1 )
+    {
+        switch( opt )
+        {
+            case 'k': kind = std::string(optarg); break;
+            case 'h': print_help(); return 1;
+            default: print_help(); return 1;
+        }
+    }
+    if( argc - optind < 2 || (kind != "dfa" && kind != "pruned" && kind != "intervals") )
+    {
+        std::cerr << "invalid arguments\n";
+        print_help();
+        exit(1);
+    }
+    std::string in_file = std::string(argv[optind]), out_file = std::string(argv[optind+1]);
+
+    if( is_binary(in_file) )
+    {
+        mapped_file f(in_file);
+        uint32_t k = bin_check(f,in_file);
+        if( k == BIN_INTERVALS )
+        {
+            std::vector< std::pair<uint,uint> > intervals;
+            read_interval(in_file,intervals);
+            write_interval(out_file,intervals);
+        }
+        else
+        {
+            DFA_edge_list D;
+            load_dfa_view(map_dfa(f,in_file,k),D);
+            if( k == BIN_PRUNED ){ write_pruned_text(out_file,D); }
+            else{ write_dfa(out_file,D); }
+        }
+        return 0;
+    }
+
+    if( kind == "intervals" )
+    {
+        std::vector< std::pair<uint,uint> > intervals;
+        read_interval(in_file,intervals);
+        write_interval_binary(out_file,intervals);
+    }
+    else
+    {
+        DFA_edge_list D;
+        if( kind == "pruned" ){ read_pruned_text(in_file,D); }
+        else{ read_dfa(in_file,D); }
+        write_dfa_binary(out_file,D,(kind == "pruned") ? BIN_PRUNED : BIN_DFA);
+    }
+
+    return 0;
+}
@@ -0,0 +1,361 @@
+#ifndef CYCLE_HPP_
+#define CYCLE_HPP_
+
+#include <algorithm>
+#include <vector>
+#include <atomic>
+#include "automaton.hpp"
+#include "parallel.hpp"
+
+/*
+    cycle detection on the A^p automaton. Every algorithm is iterative and reaches
+    the graph through slots(u), the number of successor slots of node u, and
+    target(u,k), the node in slot k of u or U_MAX if the slot is empty; this covers
+    both the CSR graph and the edges simulated on the minimum DFA. The parallel
+    algorithm calls target concurrently.
+*/
+
+// cycle detection algorithms
+enum cycle_algorithm { DFS_CYCLE, KAHN_CYCLE, PARALLEL_CYCLE };
+
+// parse an algorithm name (dfs, kahn, par)
+bool parse_cycle_algorithm(std::string name, cycle_algorithm& algo)
+{
+    if( name == "dfs" ){ algo = DFS_CYCLE; return true; }
+    if( name == "kahn" ){ algo = KAHN_CYCLE; return true; }
+    if( name == "par" ){ algo = PARALLEL_CYCLE; return true; }
+    return false;
+}
+
+// graph in compressed sparse row format: the successors of u are adj[off[u],off[u+1])
+struct csr_graph
+{
+    csr_graph(){ off.push_back(0); }
+
+    uint no_nodes(){ return static_cast<uint>(off.size()-1); }
+    size_t no_edges(){ return adj.size(); }
+
+    // close the successor list of the last node
+    void end_node(){ off.push_back(adj.size()); }
+
+    // remove all nodes, keeping the memory
+    void reset()
+    {
+        off.assign(1,0);
+        adj.clear();
+    }
+
+    // remove all nodes and release the memory
+    void clear()
+    {
+        off.assign(1,0); off.shrink_to_fit();
+        adj.clear(); adj.shrink_to_fit();
+    }
+
+    std::vector<size_t> off;
+    std::vector<uint> adj;
+};
+
+/*
+    DFS with an explicit stack of (node, next slot) pairs; stops at the first back
+    edge. explored is set to the number of visited nodes and, if cycle is given,
+    it receives the nodes of the cycle closed by the back edge.
+*/
+template <typename Slots, typename Target>
+bool dfs_cycle(uint V, Slots slots, Target target, uint& explored, std::vector<uint>* cycle = nullptr)
+{
+    std::vector<bool> visited(V,false), on_stack(V,false);
+    std::vector< std::pair<uint,uint> > stack;
+    explored = 0;
+
+    for(uint r=0;r<V;++r)
+    {
+        if( visited[r] ){ continue; }
+        visited[r] = on_stack[r] = true;
+        explored++;
+        stack.push_back({r,0});
+
+        while( !stack.empty() )
+        {
+            uint u = stack.back().first;
+            if( stack.back().second < slots(u) )
+            {
+                uint w = target(u,stack.back().second++);
+                if( w == U_MAX ){ continue; }
+                // back edge: cycle found
+                if( on_stack[w] )
+                {
+                    if( cycle != nullptr )
+                    {
+                        size_t i = stack.size()-1;
+                        while( stack[i].first != w ){ --i; }
+                        cycle->clear();
+                        for(;i<stack.size();++i){ cycle->push_back(stack[i].first); }
+                    }
+                    return true;
+                }
+                if( !visited[w] )
+                {
+                    visited[w] = on_stack[w] = true;
+                    explored++;
+                    stack.push_back({w,0});
+                }
+            }
+            else
+            {
+                on_stack[u] = false;
+                stack.pop_back();
+            }
+        }
+    }
+
+    return false;
+}
+
+/*
+    Kahn topological peel: repeatedly remove nodes with in-degree zero; the graph
+    is cyclic iff some node is never removed. explored is set to the number of
+    removed nodes and, if residual is given, it marks the nodes left. If order is
+    given, it receives the removed nodes in order: a topological order of the
+    graph if it is acyclic.
+*/
+template <typename Slots, typename Target>
+bool kahn_cycle(uint V, Slots slots, Target target, uint& explored, std::vector<bool>* residual = nullptr,
+                std::vector<uint>* order = nullptr)
+{
+    std::vector<uint> indegree(V,0), queue;
+    for(uint u=0;u<V;++u)
+        for(uint k=0;k<slots(u);++k)
+        {
+            uint w = target(u,k);
+            if( w != U_MAX ){ indegree[w]++; }
+        }
+    for(uint u=0;u<V;++u)
+        if( indegree[u] == 0 ){ queue.push_back(u); }
+
+    explored = 0;
+    while( !queue.empty() )
+    {
+        uint u = queue.back();
+        queue.pop_back();
+        explored++;
+        if( order != nullptr ){ order->push_back(u); }
+        for(uint k=0;k<slots(u);++k)
+        {
+            uint w = target(u,k);
+            if( w != U_MAX && --indegree[w] == 0 ){ queue.push_back(w); }
+        }
+    }
+
+    if( residual != nullptr )
+    {
+        residual->assign(V,false);
+        for(uint u=0;u<V;++u){ (*residual)[u] = indegree[u] > 0; }
+    }
+    return explored < V;
+}
+
+/*
+    parallel Kahn peel, level by level: the in-degrees are counted with atomic
+    increments and every level of nodes with in-degree zero is split in ranges
+    among the threads, which collect the nodes of the next level. The threads
+    are started once and meet at a barrier after every level; levels of a single
+    range are peeled by the calling thread alone, so a deep and narrow graph
+    costs no synchronization. Same answer, explored count and residual as
+    kahn_cycle.
+*/
+template <typename Slots, typename Target>
+bool parallel_kahn_cycle(uint threads, uint V, Slots slots, Target target, uint& explored, std::vector<bool>* residual = nullptr)
+{
+    std::vector< std::atomic<uint> > indegree(V);
+    // split [0,n) in ranges of at least 1024 items, a few per thread
+    auto ranges = [&](size_t n){ return std::max<size_t>(1024,n/(4*threads)+1); };
+
+    size_t chunk = ranges(V);
+    parallel_for(threads,(V+chunk-1)/chunk,[&](size_t r)
+    {
+        for(size_t u=r*chunk;u<std::min<size_t>(V,(r+1)*chunk);++u)
+            for(uint k=0;k<slots(u);++k)
+            {
+                uint w = target(u,k);
+                if( w != U_MAX ){ indegree[w].fetch_add(1,std::memory_order_relaxed); }
+            }
+    });
+
+    std::vector<uint> level, serial;
+    for(uint u=0;u<V;++u)
+        if( indegree[u].load(std::memory_order_relaxed) == 0 ){ level.push_back(u); }
+
+    // peel the nodes of level in [b,e), appending the nodes left with no incoming
+    // edge to out
+    auto peel = [&](size_t b, size_t e, std::vector<uint>& out)
+    {
+        for(size_t i=b;i<e;++i)
+            for(uint k=0;k<slots(level[i]);++k)
+            {
+                uint w = target(level[i],k);
+                // the thread removing the last incoming edge owns w
+                if( w != U_MAX && indegree[w].fetch_sub(1,std::memory_order_acq_rel) == 1 )
+                    out.push_back(w);
+            }
+    };
+
+    // move to the next level to split among the threads: the levels of a single
+    // range are peeled here. Returns false when the peel is over
+    std::vector< std::vector<uint> > next;
+    std::atomic<size_t> item(0);
+    explored = 0;
+    auto advance = [&]()
+    {
+        for(auto& n: next){ level.insert(level.end(),n.begin(),n.end()); }
+        while( !level.empty() )
+        {
+            explored += static_cast<uint>(level.size());
+            chunk = ranges(level.size());
+            if( threads > 1 && level.size() > chunk )
+            {
+                next.assign((level.size()+chunk-1)/chunk,std::vector<uint>());
+                item = 0;
+                return true;
+            }
+            serial.clear();
+            peel(0,level.size(),serial);
+            level.swap(serial);
+        }
+        next.clear();
+        return false;
+    };
+
+    if( advance() )
+    {
+        thread_barrier barrier(threads);
+        bool more = true;
+        parallel_run(threads,[&](uint id)
+        {
+            while( true )
+            {
+                for(size_t r=item++;r<next.size();r=item++)
+                    peel(r*chunk,std::min(level.size(),(r+1)*chunk),next[r]);
+                barrier.wait();
+                if( id == 0 ){ level.clear(); more = advance(); }
+                barrier.wait();
+                if( !more ){ return; }
+            }
+        });
+    }
+
+    if( residual != nullptr )
+    {
+        residual->assign(V,false);
+        for(uint u=0;u<V;++u){ (*residual)[u] = indegree[u].load(std::memory_order_relaxed) > 0; }
+    }
+    return explored < V;
+}
+
+/*
+    cycle detection with the chosen algorithm. If cycle is given and the graph is
+    cyclic, it receives the nodes of a cycle: the peeling algorithms leave a set
+    of nodes closed under successors, which is searched by DFS.
+*/
+template <typename Slots, typename Target>
+bool find_cycle(cycle_algorithm algo, uint threads, uint V, Slots slots, Target target, uint& explored,
+                std::vector<uint>* cycle = nullptr)
+{
+    if( algo == DFS_CYCLE ){ return dfs_cycle(V,slots,target,explored,cycle); }
+
+    std::vector<bool> residual;
+    bool cyclic = (algo == PARALLEL_CYCLE)
+        ? parallel_kahn_cycle(threads,V,slots,target,explored,cycle ? &residual : nullptr)
+        : kahn_cycle(V,slots,target,explored,cycle ? &residual : nullptr);
+    if( cyclic && cycle != nullptr )
+    {
+        uint e = 0;
+        dfs_cycle(V,[&](uint u){ return residual[u] ? slots(u) : 0; },target,e,cycle);
+    }
+    return cyclic;
+}
+
+/*
+    iterative Tarjan visit of the strongly connected components: loop(u) is called
+    on every self loop and component(first,last) on the nodes of every component,
+    an iterator range, in reverse topological order of the components
+*/
+template <typename Slots, typename Target, typename Loop, typename Component>
+void tarjan_scc(uint V, Slots slots, Target target, Loop loop, Component component)
+{
+    std::vector<bool> on_stack(V,false);
+    std::vector<uint> index(V,U_MAX), low(V,0), scc_stack;
+    // visit stack: node and next slot
+    std::vector< std::pair<uint,uint> > stack;
+    uint counter = 0;
+
+    for(uint r=0;r<V;++r)
+    {
+        if( index[r] != U_MAX ){ continue; }
+        index[r] = low[r] = counter++;
+        scc_stack.push_back(r); on_stack[r] = true;
+        stack.push_back({r,0});
+
+        while( !stack.empty() )
+        {
+            uint u = stack.back().first;
+            if( stack.back().second < slots(u) )
+            {
+                uint w = target(u,stack.back().second++);
+                if( w == U_MAX ){ continue; }
+                if( w == u ){ loop(u); }
+                if( index[w] == U_MAX )
+                {
+                    index[w] = low[w] = counter++;
+                    scc_stack.push_back(w); on_stack[w] = true;
+                    stack.push_back({w,0});
+                }
+                else if( on_stack[w] ){ low[u] = std::min(low[u],index[w]); }
+                continue;
+            }
+            stack.pop_back();
+            if( !stack.empty() ){ low[stack.back().first] = std::min(low[stack.back().first],low[u]); }
+            // u is the root of a strongly connected component
+            if( low[u] == index[u] )
+            {
+                auto first = std::find(scc_stack.rbegin(),scc_stack.rend(),u).base()-1;
+                for(auto it=first;it!=scc_stack.end();++it){ on_stack[*it] = false; }
+                component(first,scc_stack.end());
+                scc_stack.erase(first,scc_stack.end());
+            }
+        }
+    }
+}
+
+/*
+    mark the nodes lying on a cycle, i.e. belonging to a strongly connected component
+    with more than one node or having a self loop
+*/
+template <typename Slots, typename Target>
+std::vector<bool> cyclic_nodes(uint V, Slots slots, Target target)
+{
+    std::vector<bool> cyclic(V,false);
+    tarjan_scc(V,slots,target,[&](uint u){ cyclic[u] = true; },[&](auto first, auto last)
+    {
+        if( last-first > 1 )
+            for(;first!=last;++first){ cyclic[*first] = true; }
+    });
+    return cyclic;
+}
+
+// strongly connected component of every node, numbered in reverse topological
+// order; returns their number
+template <typename Slots, typename Target>
+uint scc_ids(uint V, Slots slots, Target target, std::vector<uint>& scc)
+{
+    scc.assign(V,U_MAX);
+    uint c = 0;
+    tarjan_scc(V,slots,target,[](uint){},[&](auto first, auto last)
+    {
+        for(;first!=last;++first){ scc[*first] = c; }
+        c++;
+    });
+    return c;
+}
+
+#endif
@@ -0,0 +1,370 @@
+#include <unistd.h>
+#include <spawn.h>
+#include <sys/wait.h>
+#include <mutex>
+#include <sstream>
+#include "automaton.hpp"
+#include "utils.hpp"
+#include "hashing_function.hpp"
+// DFA minimization
+#include "minimize.hpp"
+// pruning and interval computation
+#include "intervals.hpp"
+// A^p construction and cycle detection
+#include "width.hpp"
+// worker pool
+#include "parallel.hpp"
+// result cache
+#include "cache.hpp"
+
+extern char** environ;
+
+// one line of the manifest: a DFA file or a regexp and the query on its language
+struct batch_job
+{
+    size_t line = 0;
+    bool regexp = false;
+    std::string input;
+    uint p = 2;
+    bool exact = false, wheeler = false;
+    // parse error of the line, if any
+    std::string error;
+};
+
+// options shared by all the jobs
+struct batch_config
+{
+    uint p = 2;
+    bool exact = false, memory = false, lazy = false;
+    cycle_algorithm algo = DFS_CYCLE;
+    std::string converter;
+    // shared by the workers, null without -c
+    result_cache* cache = nullptr;
+};
+
+void print_help( void )
+{
+    std::cout << "usage: det-width-batch.x [options] manifest" << std::endl;
+    std::cout << "answers the width queries of the manifest (- for stdin), one per line:" << std::endl;
+    std::cout << "  dfa <file> [query]  or  regexp <regexp> [query]  (the regexp may contain spaces)" << std::endl;
+    std::cout << "with query -p [p], -e (exact width) or -W (Wheeler check, p = 2); empty lines and lines" << std::endl;
+    std::cout << "starting with # are skipped. One JSON line per job is written, in manifest order" << std::endl;
+    std::cout << " -j [n]    : number of worker threads (def. 1)" << std::endl;
+    std::cout << " -o [file] : write the results to file (def. stdout)" << std::endl;
+    std::cout << " -p [p]    : p of the jobs without a query (def. 2)" << std::endl;
+    std::cout << " -e        : compute the exact width for the jobs without a query" << std::endl;
+    std::cout << " -m        : reduced memory A^p check (as det-width-rm.x)" << std::endl;
+    std::cout << " -l        : on-the-fly A^p check, stops at the first cycle (p check only)" << std::endl;
+    std::cout << " -a [algo] : cycle detection algorithm, dfs or kahn (def. dfs)" << std::endl;
+    std::cout << " -r [exe]  : regexp to minimum DFA converter (def. external/RegexpToAutomaton/regToAutomaton)" << std::endl;
+    std::cout << " -c [dir]  : result cache directory (see det-width-pipe.x)" << std::endl;
+}
+
+// escape s for a JSON string
+std::string json_string(const std::string& s)
+{
+    std::string r = "\"";
+    for(char c: s)
+    {
+        if( c == '"' || c == '\\' ){ r += '\\'; r += c; }
+        else if( static_cast<unsigned char>(c) < 0x20 )
+        {
+            char b[8];
+            std::snprintf(b,sizeof(b),"\\u%04x",c);
+            r += b;
+        }
+        else{ r += c; }
+    }
+    return r + "\"";
+}
+
+// parse a manifest line (already known to be non-empty) into job. A DFA file is one
+// token; a regexp is the rest of the line up to the query options ending it, so it
+// may contain spaces
+void parse_job(const std::string& s, const batch_config& cfg, batch_job& job)
+{
+    // tokens and their offsets in the line
+    std::vector<std::string> tok;
+    std::vector<size_t> at;
+    for(size_t i=s.find_first_not_of(" \t\r");i!=std::string::npos;i=s.find_first_not_of(" \t\r",i))
+    {
+        size_t e = std::min(s.find_first_of(" \t\r",i),s.size());
+        tok.push_back(s.substr(i,e-i));
+        at.push_back(i);
+        i = e;
+    }
+    job.p = cfg.p;
+    job.exact = cfg.exact;
+    std::string kind = tok.empty() ? "" : tok[0];
+    if( kind == "regexp" ){ job.regexp = true; }
+    else if( kind != "dfa" ){ job.error = "unknown input kind: " + kind; return; }
+    if( tok.size() < 2 ){ job.error = "missing input"; return; }
+
+    auto is_p = [](const std::string& t){ return t == "-p" || t == "--p"; };
+    size_t k = 2;
+    if( job.regexp )
+    {
+        // the options are the longest suffix of flags and -p arguments after the regexp
+        k = tok.size();
+        while( k > 2 )
+        {
+            const std::string& t = tok[k-1];
+            if( t == "-e" || t == "--exact" || t == "-W" || t == "--Wheeler" || is_p(t) ){ k--; }
+            else if( k > 3 && is_p(tok[k-2]) ){ k -= 2; }
+            else{ break; }
+        }
+        job.input = s.substr(at[1],at[k-1]+tok[k-1].size()-at[1]);
+    }
+    else{ job.input = tok[1]; }
+
+    for(;k<tok.size();++k)
+    {
+        if( is_p(tok[k]) )
+        {
+            if( ++k == tok.size() || tok[k].find_first_not_of("0123456789") != std::string::npos || read_uint<uint>(tok[k]) < 2 )
+            {
+                job.error = "invalid p";
+                return;
+            }
+            job.p = read_uint<uint>(tok[k]);
+            job.exact = job.wheeler = false;
+        }
+        else if( tok[k] == "-e" || tok[k] == "--exact" ){ job.exact = true; job.wheeler = false; }
+        else if( tok[k] == "-W" || tok[k] == "--Wheeler" ){ job.wheeler = true; job.exact = false; job.p = 2; }
+        else{ job.error = "unknown option: " + tok[k]; return; }
+    }
+}
+
+// minimum DFA of the regexp from the external converter, read through a pipe (as in
+// determWidth.py the regexp is prefixed by the $ source edge); false with error set on failure
+bool regexp_to_dfa(const std::string& converter, const std::string& regexp, DFA_edge_list& D, std::string& error)
+{
+    if( access(converter.c_str(),X_OK) != 0 ){ error = "cannot run the regexp converter " + converter; return false; }
+    int fd[2];
+    if( pipe(fd) != 0 ){ error = "cannot create a pipe"; return false; }
+    std::string re = "($)(" + regexp + ")", opt = "--DFAmin";
+    char* args[] = { const_cast<char*>(converter.c_str()), &re[0], &opt[0], nullptr };
+    posix_spawn_file_actions_t actions;
+    posix_spawn_file_actions_init(&actions);
+    posix_spawn_file_actions_adddup2(&actions,fd[1],STDOUT_FILENO);
+    posix_spawn_file_actions_addclose(&actions,fd[0]);
+    posix_spawn_file_actions_addclose(&actions,fd[1]);
+    pid_t pid;
+    int err = posix_spawn(&pid,converter.c_str(),&actions,nullptr,args,environ);
+    posix_spawn_file_actions_destroy(&actions);
+    close(fd[1]);
+    if( err != 0 ){ close(fd[0]); error = "cannot run the regexp converter " + converter; return false; }
+
+    bool ok;
+    {
+        text_reader input(fdopen(fd[0],"rb"),true);
+        ok = read_dfa(input,D);
+        // drain the pipe, so that the converter can terminate
+        while( input.get() != EOF ){}
+    }
+    int status;
+    waitpid(pid,&status,0);
+    if( !ok || !WIFEXITED(status) || WEXITSTATUS(status) != 0 )
+    {
+        error = "the regexp converter failed";
+        return false;
+    }
+    return true;
+}
+
+// run job and return its result line
+std::string run_job(const batch_job& job, const batch_config& cfg)
+{
+    std::ostringstream out;
+    out << "{\"line\":" << job.line << ",\"kind\":\"" << (job.regexp ? "regexp" : "dfa") << "\""
+        << ",\"input\":" << json_string(job.input);
+    auto fail = [&](const std::string& e){ out << ",\"error\":" << json_string(e) << "}"; return out.str(); };
+    if( job.error.size() > 0 ){ return fail(job.error); }
+    out << ",\"query\":\"" << (job.exact ? "exact" : job.wheeler ? "wheeler" : "p") << "\"";
+    if( !job.exact ){ out << ",\"p\":" << job.p; }
+
+    stopwatch sw;
+    DFA_edge_list D;
+    std::string error;
+    if( job.regexp )
+    {
+        if( !regexp_to_dfa(cfg.converter,job.input,D,error) ){ return fail(error); }
+    }
+    else if( is_binary(job.input) )
+    {
+        if( !read_dfa_binary(job.input,D) ){ return fail("invalid DFA"); }
+    }
+    else
+    {
+        text_reader input(job.input);
+        if( !input.is_open() ){ return fail("cannot open the input"); }
+        if( !read_dfa(input,D) ){ return fail("invalid DFA"); }
+    }
+    if( D.nodes == 0 || D.source >= D.nodes ){ return fail("invalid DFA"); }
+    for(auto& e: D.edges)
+        if( e.origin >= D.nodes || e.dest >= D.nodes ){ return fail("invalid DFA: state out of range"); }
+    for(auto f: D.accepting)
+        if( f >= D.nodes ){ return fail("invalid DFA: state out of range"); }
+
+    // the stages of det-width-pipe.x
+    DFA_edge_list D_min;
+    minimize_dfa(D,D_min);
+    D = DFA_edge_list();
+    out << ",\"min_states\":" << D_min.nodes;
+
+    // answer from the cache if the known bounds are enough
+    width_bounds bounds;
+    std::string key;
+    std::vector< std::pair<uint,uint> > intervals;
+    bool cached_intervals = false;
+    if( cfg.cache != nullptr )
+    {
+        DFA_edge_list C;
+        canonical_dfa(D_min,C);
+        D_min = std::move(C);
+        key = cfg.cache->key(D_min);
+        cfg.cache->lookup(D_min,bounds,&intervals,&cached_intervals);
+        if( job.exact && bounds.exact() )
+        {
+            out << ",\"width\":" << bounds.lo << ",\"cached\":true,\"time\":" << sw.elapsed() << "}";
+            return out.str();
+        }
+        if( !job.exact && bounds.answer(job.p) >= 0 )
+        {
+            out << ",\"width_lt_p\":" << (bounds.answer(job.p) == 1 ? "true" : "false")
+                << ",\"cached\":true,\"time\":" << sw.elapsed() << "}";
+            return out.str();
+        }
+    }
+    if( !cached_intervals )
+    {
+        DFA_edge_list D_prmin, D_prmax;
+        prune_dfa(D_min,D_prmin,D_prmax);
+        compute_intervals(D_prmin,D_prmax,intervals);
+    }
+    bool cache = (cfg.cache != nullptr) && cfg.cache->store(D_min,bounds,cached_intervals ? nullptr : &intervals);
+
+    if( cfg.memory )
+        for(auto& i: intervals)
+            if( i.first == i.second ){ i = std::make_pair(0,0); }
+    min_dfa M(D_min);
+    D_min = DFA_edge_list();
+
+    if( job.exact )
+    {
+        width_checker W(M,intervals);
+        W.set_cycle_algorithm(cfg.algo);
+        uint width = W.exact_width(cfg.memory,bounds.lo,bounds.hi);
+        bounds.set_exact(width);
+        out << ",\"width\":" << width;
+    }
+    else
+    {
+        // p greater than the number of states: the width is smaller than p
+        bool cyclic = false;
+        if( job.p <= intervals.size() )
+        {
+            width_checker W(M,intervals);
+            W.set_cycle_algorithm(cfg.algo);
+            cyclic = cfg.lazy ? W.find_cycle_lazy(job.p) : cfg.memory ? W.find_cycle_sim(job.p)
+                   : (job.p == 2) ? W.find_cycle_pairs() : W.find_cycle(job.p);
+        }
+        bounds.add(job.p,cyclic);
+        out << ",\"width_lt_p\":" << (cyclic ? "false" : "true");
+    }
+    if( cache ){ cfg.cache->store_bounds(key,bounds); }
+    out << ",\"time\":" << sw.elapsed() << "}";
+    return out.str();
+}
+
+int main(int argc, char** argv)
+{
+    int opt;
+    uint threads = 1;
+    batch_config cfg;
+    std::string out_file, cache_dir;
+    // the converter is looked for next to the build directory, as in determWidth.py
+    std::string exe_dir = std::string(argv[0]);
+    exe_dir = (exe_dir.find('/') != std::string::npos) ? exe_dir.substr(0,exe_dir.rfind('/')) : ".";
+    cfg.converter = exe_dir + "/../external/RegexpToAutomaton/regToAutomaton";
+    while( ( opt = getopt( argc, argv, "j:o:p:a:r:c:emlh" ) ) != -1 )
+    {
+        switch( opt )
+        {
+            case 'j': threads = std::max<uint>(read_uint<uint>(optarg),1); break;
+            case 'o': out_file = std::string(optarg); break;
+            case 'p': cfg.p = read_uint<uint>(optarg); break;
+            case 'e': cfg.exact = true; break;
+            case 'm': cfg.memory = true; break;
+            case 'l': cfg.lazy = true; break;
+            case 'a':
+                // the jobs run on one thread each, so the parallel algorithm is not offered
+                if( !parse_cycle_algorithm(optarg,cfg.algo) || cfg.algo == PARALLEL_CYCLE )
+                {
+                    std::cerr << "unknown cycle detection algorithm: " << optarg << "\n";
+                    print_help();
+                    exit(1);
+                }
+                break;
+            case 'r': cfg.converter = std::string(optarg); break;
+            case 'c': cache_dir = std::string(optarg); break;
+            case 'h': print_help(); return 1;
+            default: print_help(); return 1;
+        }
+    }
+    if( optind >= argc || cfg.p < 2 )
+    {
+        std::cerr << "invalid arguments\n";
+        print_help();
+        exit(1);
+    }
+    std::string manifest = std::string(argv[optind]);
+
+    // read the jobs
+    std::vector<batch_job> jobs;
+    {
+        std::ifstream file;
+        if( manifest != "-" )
+        {
+            file.open(manifest);
+            if( !file.is_open() ){ std::cerr << "cannot open " << manifest << "\n"; exit(1); }
+        }
+        std::istream& in = (manifest != "-") ? file : std::cin;
+        std::string s;
+        for(size_t line=1;std::getline(in,s);++line)
+        {
+            size_t b = s.find_first_not_of(" \t\r");
+            if( b == std::string::npos || s[b] == '#' ){ continue; }
+            jobs.push_back(batch_job());
+            jobs.back().line = line;
+            parse_job(s,cfg,jobs.back());
+        }
+    }
+
+    std::unique_ptr<result_cache> cache;
+    if( cache_dir.size() > 0 ){ cache.reset(new result_cache(cache_dir)); cfg.cache = cache.get(); }
+
+    std::ofstream ofile;
+    if( out_file.size() > 0 ){ ofile.open(out_file); }
+    std::ostream& out = (out_file.size() > 0) ? ofile : std::cout;
+
+    // the results are written in manifest order as soon as all the previous ones are done
+    std::vector<std::string> results(jobs.size());
+    std::vector<bool> done(jobs.size(),false);
+    size_t next = 0;
+    std::mutex m;
+    parallel_for(threads,jobs.size(),[&](size_t k)
+    {
+        std::string r = run_job(jobs[k],cfg);
+        std::lock_guard<std::mutex> lock(m);
+        results[k] = std::move(r);
+        done[k] = true;
+        for(;next<jobs.size() && done[next];++next)
+        {
+            out << results[next] << std::endl;
+            results[next] = std::string();
+        }
+    });
+
+    return 0;
+}
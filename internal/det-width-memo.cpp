@@ -0,0 +1,136 @@
+#include <unistd.h>
+#include <sstream>
+#include "automaton.hpp"
+#include "utils.hpp"
+#include "hashing_function.hpp"
+// width queries memoized across the updates of the DFA
+#include "memoized.hpp"
+
+void print_help( void )
+{
+    std::cout << "usage: det-width-memo.x [options] input.dfa updates" << std::endl;
+    std::cout << "answers the query on the input DFA and again after every update of its transitions" << std::endl;
+    std::cout << "read from the updates file (- for stdin), one per line:" << std::endl;
+    std::cout << "  + origin label dest  (add the transition)  or  - origin label dest  (remove it)" << std::endl;
+    std::cout << "with the labels as in the DFA files; a line = ends an update, as does the end of the file." << std::endl;
+    std::cout << "The answers are kept while the minimum DFA does not change; otherwise they are recomputed." << std::endl;
+    std::cout << "One JSON line per update is written, the first one for the input DFA" << std::endl;
+    std::cout << " -p [p]    : check if the width is < p (def. 2)" << std::endl;
+    std::cout << " -e        : compute the exact width" << std::endl;
+    std::cout << " -t [n]    : number of threads of the A^p construction (def. 1)" << std::endl;
+    std::cout << " -a [algo] : cycle detection algorithm, dfs, kahn or par (def. dfs)" << std::endl;
+    std::cout << " -o [file] : write the results to file (def. stdout)" << std::endl;
+}
+
+// parse a transition line "+ origin label dest" or "- origin label dest" into delta
+bool parse_edge(const std::string& s, edge_delta& delta)
+{
+    std::istringstream in(s);
+    std::string op, extra;
+    uint64_t origin, label, dest;
+    if( !(in >> op >> origin >> label >> dest) || (in >> extra) || (op != "+" && op != "-") ){ return false; }
+    if( origin >= U_MAX || dest >= U_MAX || label > 255 ){ return false; }
+    transition t;
+    t.origin = static_cast<uint>(origin);
+    t.label = static_cast<char>(label);
+    t.dest = static_cast<uint>(dest);
+    (op == "+" ? delta.added : delta.removed).push_back(t);
+    return true;
+}
+
+int main(int argc, char** argv)
+{
+    int opt;
+    uint p = 2, threads = 1;
+    bool exact = false;
+    cycle_algorithm algo = DFS_CYCLE;
+    std::string out_file;
+    while( ( opt = getopt( argc, argv, "p:t:a:o:eh" ) ) != -1 )
+    {
+        switch( opt )
+        {
+            case 'p': p = read_uint<uint>(optarg); break;
+            case 't': threads = std::max<uint>(read_uint<uint>(optarg),1); break;
+            case 'a':
+                if( !parse_cycle_algorithm(optarg,algo) )
+                {
+                    std::cerr << "unknown cycle detection algorithm: " << optarg << "\n";
+                    print_help();
+                    exit(1);
+                }
+                break;
+            case 'o': out_file = std::string(optarg); break;
+            case 'e': exact = true; break;
+            case 'h': print_help(); return 1;
+            default: print_help(); return 1;
+        }
+    }
+    if( optind + 1 >= argc || p < 2 )
+    {
+        std::cerr << "invalid arguments\n";
+        print_help();
+        exit(1);
+    }
+    std::string input_file = std::string(argv[optind]);
+    std::string updates = std::string(argv[optind+1]);
+
+    std::ifstream file;
+    if( updates != "-" )
+    {
+        file.open(updates);
+        if( !file.is_open() ){ std::cerr << "cannot open " << updates << "\n"; exit(1); }
+    }
+    std::istream& in = (updates != "-") ? file : std::cin;
+
+    std::ofstream ofile;
+    if( out_file.size() > 0 ){ ofile.open(out_file); }
+    std::ostream& out = (out_file.size() > 0) ? ofile : std::cout;
+
+    DFA_edge_list D;
+    read_dfa(input_file,D);
+    stopwatch sw;
+    memoized_width I(D);
+    I.set_threads(threads);
+    I.set_cycle_algorithm(algo);
+
+    // answer the query on the current DFA and write its JSON line
+    size_t step = 0;
+    auto answer = [&](const edge_delta& delta, double update_time)
+    {
+        const auto& info = I.last_update();
+        out << "{\"update\":" << step << ",\"added\":" << delta.added.size() << ",\"removed\":" << delta.removed.size();
+        out << ",\"min_states\":" << I.minimum().nodes << ",\"min_changed\":" << (info.min_changed ? "true" : "false");
+        out << ",\"witness_kept\":" << (info.witness_kept ? "true" : "false") << ",\"lo\":" << info.lo;
+        stopwatch q;
+        if( exact ){ out << ",\"width\":" << I.width(); }
+        else{ out << ",\"p\":" << p << ",\"width_lt_p\":" << (I.width_lt(p) ? "true" : "false"); }
+        out << ",\"update_time\":" << update_time << ",\"query_time\":" << q.elapsed() << "}" << std::endl;
+    };
+    answer(edge_delta(),sw.elapsed());
+
+    // apply the updates: a bad line or a rejected delta skips its whole update
+    edge_delta delta;
+    std::string error;
+    size_t line = 0;
+    auto flush = [&]()
+    {
+        step++;
+        if( error.empty() && I.update(delta,error) ){ answer(delta,I.last_update().time); }
+        else{ out << "{\"update\":" << step << ",\"error\":\"" << error << "\"}" << std::endl; }
+        delta = edge_delta();
+        error.clear();
+    };
+    std::string s;
+    bool pending = false;
+    while( std::getline(in,s) )
+    {
+        line++;
+        size_t b = s.find_first_not_of(" \t\r");
+        if( b == std::string::npos || s[b] == '#' ){ continue; }
+        if( s.compare(b,1,"=") == 0 ){ flush(); pending = false; continue; }
+        pending = true;
+        if( error.empty() && !parse_edge(s,delta) ){ error = "invalid line " + std::to_string(line); }
+    }
+    if( pending ){ flush(); }
+    if( out_file.size() > 0 ){ ofile.close(); }
+}
@@ -0,0 +1,265 @@
+#include <unistd.h>
+#include "automaton.hpp"
+#include "utils.hpp"
+#include "hashing_function.hpp"
+// DFA minimization
+#include "minimize.hpp"
+// pruning and interval computation
+#include "intervals.hpp"
+// A^p construction and cycle detection
+#include "width.hpp"
+// result cache
+#include "cache.hpp"
+// width certificates
+#include "certificate.hpp"
+
+// write the answer to file: 1 if the width is < p, 0 otherwise
+void write_answer(std::string out_answer, bool cyclic)
+{
+    if( out_answer.size() == 0 ){ return; }
+    std::ofstream ofile(out_answer);
+    ofile << (cyclic ? 0 : 1);
+    ofile.close();
+}
+
+// print the answer of a p query and write it to file
+void report(uint p, bool cyclic, std::string out_answer)
+{
+    if( cyclic )
+        std::cout << p << "-cycle found! The language width is >=(greater or equal than) " << p << ".\n";
+    else
+        std::cout << "No " << p << "-cycle found! The language width is <(smaller than) " << p << ".\n";
+    write_answer(out_answer,cyclic);
+}
+
+// print the exact width and write it to file
+void report_width(uint width, std::string out_answer)
+{
+    std::cout << "The language width is " << width << ".\n";
+    if( out_answer.size() > 0 )
+    {
+        std::ofstream ofile(out_answer);
+        ofile << width;
+        ofile.close();
+    }
+}
+
+void print_help( void )
+{
+    std::cout << "usage: det-width-pipe.x [options] input.dfa" << std::endl;
+    std::cout << " -p [p]    : check if the deterministic width is < p (def. 2, Wheeler check)" << std::endl;
+    std::cout << " -e        : compute the exact deterministic width" << std::endl;
+    std::cout << " -m        : reduced memory A^p check (as det-width-rm.x)" << std::endl;
+    std::cout << " -l        : on-the-fly A^p check, stops at the first cycle (p check only)" << std::endl;
+    std::cout << " -n        : only count the p-tuples of overlapping states enumerated from L (an upper bound" << std::endl;
+    std::cout << "             on the states of A^p), without building A^p" << std::endl;
+    std::cout << " -t [n]    : number of threads building A^p and running -a par (def. 1)" << std::endl;
+    std::cout << " -a [algo] : cycle detection algorithm, dfs, kahn or par (def. dfs)" << std::endl;
+    std::cout << " -w        : print a cycle of A^p when one is found" << std::endl;
+    std::cout << " -C [file] : write a certificate of the answer to file: a cycle of A^p if the width is >= p," << std::endl;
+    std::cout << "             a topological order of A^p and co-lex chains otherwise (all with -e)" << std::endl;
+    std::cout << " -k        : keep intermediate files (input.min, input.min.prmin, input.min.prmax, input.min.interval)" << std::endl;
+    std::cout << " -o [file] : write the answer to file (1 if width < p, 0 otherwise; the width with -e)" << std::endl;
+    std::cout << " -c [dir]  : result cache directory, shared by the runs on the same minimum DFA" << std::endl;
+    std::cout << " -s [file] : write the time, peak memory and counters of every phase to file (JSON)" << std::endl;
+}
+
+int main(int argc, char** argv)
+{
+    int opt;
+    uint p = 2;
+    bool memory = false, keep = false, exact = false, lazy = false, witness = false, count = false;
+    std::string out_answer, cache_dir, stats_file, cert_file;
+    cycle_algorithm algo = DFS_CYCLE;
+    uint threads = 1;
+    while( ( opt = getopt( argc, argv, "p:o:a:t:c:s:C:emlnwkh" ) ) != -1 )
+    {
+        switch( opt )
+        {
+            case 'p': p = read_uint<uint>(optarg); break;
+            case 'o': out_answer = std::string(optarg); break;
+            case 'e': exact = true; break;
+            case 'a':
+                if( !parse_cycle_algorithm(optarg,algo) )
+                {
+                    std::cerr << "unknown cycle detection algorithm: " << optarg << "\n";
+                    print_help();
+                    exit(1);
+                }
+                break;
+            case 'm': memory = true; break;
+            case 'l': lazy = true; break;
+            case 'n': count = true; break;
+            case 'w': witness = true; break;
+            case 't': threads = read_uint<uint>(optarg); break;
+            case 'k': keep = true; break;
+            case 'c': cache_dir = std::string(optarg); break;
+            case 's': stats_file = std::string(optarg); break;
+            case 'C': cert_file = std::string(optarg); break;
+            case 'h': print_help(); return 1;
+            default: print_help(); return 1;
+        }
+    }
+    if( optind >= argc || p < 2 || (count && (exact || cert_file.size() > 0)) )
+    {
+        std::cerr << "invalid arguments\n";
+        print_help();
+        exit(1);
+    }
+    std::string in_dfa = std::string(argv[optind]);
+
+    // per-phase statistics, written with the answer (the width for -e)
+    std::unique_ptr<run_stats> rs;
+    if( stats_file.size() > 0 ){ rs.reset(new run_stats("det-width-pipe.x")); }
+    auto phase = [&](const char* name){ if( rs ){ rs->begin(name); } };
+    auto done = [&](bool cached, size_t answer)
+    {
+        if( !rs ){ return; }
+        if( count ){ rs->set("p",p); rs->set("tuples",answer); }
+        else if( exact ){ rs->set("width",answer); }
+        else{ rs->set("p",p); rs->set("width_lt_p",answer ? "true" : "false"); }
+        rs->set("cached",cached ? "true" : "false");
+        rs->write(stats_file);
+    };
+
+    // certificate of the answer (see certificate.hpp): the cycle found by W if the width
+    // is >= p, otherwise a topological order of the acyclic A^q (q = p, or the width + 1
+    // for -e), followed by the co-lex chains of M as an order to index with
+    bool cert = cert_file.size() > 0;
+    auto certify = [&](const std::string& answer, uint q, const min_dfa& M, uint source, width_checker* W, bool cyclic)
+    {
+        if( !cert ){ return; }
+        phase("certificate");
+        std::ofstream out(cert_file);
+        out << answer << "\n";
+        if( cyclic ){ W->write_witness(out); }
+        if( cyclic && !exact ){ return; }
+        // without a checker q exceeds the number of states of M, so A^q has no states
+        if( W == nullptr ){ out << "order " << q << " 0\n"; }
+        else{ W->write_order(out,q); }
+        phase("colex_chains");
+        std::vector< std::vector< std::pair<uint,uint> > > chains;
+        colex_chains(M,source,chains);
+        write_chains(out,chains);
+        if( rs ){ rs->count("chains",chains.size()); }
+    };
+
+    // read the input DFA and compute the minimum DFA
+    DFA_edge_list D, D_min;
+    phase("read_dfa");
+    read_dfa(in_dfa,D);
+    if( rs ){ rs->count("states",D.nodes); rs->count("edges",D.edges.size()); }
+    phase("minimize");
+    minimize_dfa(D,D_min);
+    if( rs ){ rs->count("states",D_min.nodes); rs->count("edges",D_min.edges.size()); }
+    D.edges.clear();
+    D.edges.shrink_to_fit();
+
+    // with a cache the minimum DFA is renumbered in canonical order, and the query
+    // may be answered by the known bounds (unless a witness or the files are wanted)
+    std::unique_ptr<result_cache> cache;
+    width_bounds bounds;
+    std::string key;
+    std::vector< std::pair<uint,uint> > intervals;
+    bool cached_intervals = false;
+    if( cache_dir.size() > 0 )
+    {
+        phase("cache_lookup");
+        cache.reset(new result_cache(cache_dir));
+        DFA_edge_list C;
+        canonical_dfa(D_min,C);
+        D_min = std::move(C);
+        key = cache->key(D_min);
+        cache->lookup(D_min,bounds,&intervals,&cached_intervals);
+        if( exact && !keep && !cert && bounds.exact() ){ report_width(bounds.lo,out_answer); done(true,bounds.lo); return 0; }
+        if( !exact && !keep && !witness && !cert && !count && p <= D_min.nodes && bounds.answer(p) >= 0 )
+        {
+            report(p,bounds.answer(p) == 0,out_answer);
+            done(true,bounds.answer(p));
+            return 0;
+        }
+    }
+    if( keep ){ write_dfa(in_dfa+".min",D_min); }
+
+    #ifdef VERBOSE
+    {
+        std::cout << "### minimum DFA ###\n";
+        std::cout << "Nodes: " << D_min.nodes << "\n";
+        std::cout << "Edges: " << D_min.edges.size() << "\n";
+        std::cout << "Source: " << D_min.source << "\n";
+    }
+    #endif
+
+    // compute the infimum and supremum pruned DFAs and the intervals
+    if( !cached_intervals )
+    {
+        DFA_edge_list D_prmin, D_prmax;
+        phase("prune");
+        prune_dfa(D_min,D_prmin,D_prmax);
+        if( rs ){ rs->count("min_edges",D_prmin.edges.size()); rs->count("max_edges",D_prmax.edges.size()); }
+        if( keep )
+        {
+            write_dfa(in_dfa+".min.prmin",D_prmin);
+            write_dfa(in_dfa+".min.prmax",D_prmax);
+        }
+        phase("intervals");
+        compute_intervals(D_prmin,D_prmax,intervals);
+    }
+    if( keep ){ write_interval(in_dfa+".min.interval",intervals); }
+    if( cache && !cache->store(D_min,bounds,cached_intervals ? nullptr : &intervals) ){ cache.reset(); }
+
+    // stop if p is greater than the number of states in the minimum DFA
+    if( !exact && !count && p > intervals.size() )
+    {
+        std::cout << "The tested width is greater than the number of states in the minimum DFA\n";
+        write_answer(out_answer,false);
+        certify("width < "+std::to_string(p),p,min_dfa(D_min),D_min.source,nullptr,false);
+        done(false,1);
+        exit(0);
+    }
+
+    // states whose infimum equals the supremum cannot lie on a cycle
+    if( memory )
+        for(auto& i: intervals)
+            if( i.first == i.second ){ i = std::make_pair(0,0); }
+
+    phase("min_dfa");
+    min_dfa M(D_min);
+    D_min.edges.clear();
+    D_min.edges.shrink_to_fit();
+
+    // sort the intervals, create L data structure and check A^p cyclicity
+    width_checker W(M,intervals,rs.get());
+    W.set_cycle_algorithm(algo);
+    W.set_threads(threads);
+    W.set_witness(witness || cert);
+    if( count )
+    {
+        size_t n = W.tuple_count(p);
+        std::cout << "Number of p-tuples of overlapping states (p = " << p << "): " << n << "\n";
+        done(false,n);
+        return 0;
+    }
+    if( exact )
+    {
+        uint width = W.exact_width(memory,bounds.lo,bounds.hi);
+        report_width(width,out_answer);
+        // with the witness set, the search keeps a cycle of A^width
+        bool found = cert && width >= 2 && !W.witness().empty();
+        certify("width = "+std::to_string(width),width+1,M,D_min.source,&W,found);
+        done(false,width);
+        bounds.set_exact(width);
+    }
+    else
+    {
+        bool cyclic = lazy ? W.find_cycle_lazy(p) : memory ? W.find_cycle_sim(p) : (p == 2) ? W.find_cycle_pairs() : W.find_cycle(p);
+        report(p,cyclic,out_answer);
+        if( cyclic && witness ){ W.print_witness(std::cout); }
+        certify((cyclic ? "width >= " : "width < ")+std::to_string(p),p,M,D_min.source,&W,cyclic);
+        done(false,!cyclic);
+        bounds.add(p,cyclic);
+    }
+    if( cache ){ cache->store_bounds(key,bounds); }
+
+    return 0;
+}
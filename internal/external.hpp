@@ -0,0 +1,220 @@
+#ifndef EXTERNAL_HPP_
+#define EXTERNAL_HPP_
+
+#include <cstdio>
+#include <cstdlib>
+#include <queue>
+#include <memory>
+#include <unistd.h>
+#include "automaton.hpp"
+
+/*
+    external memory tools: files of fixed-size records written and read
+    sequentially, and a merge sort of records within a memory budget. The files
+    are created in a temporary directory and unlinked at once, so that they are
+    removed when closed, also on exit.
+*/
+
+// temporary directory and memory budget (bytes) of the external memory algorithms
+struct ext_config
+{
+    std::string dir;
+    size_t budget;
+
+    ext_config(std::string dir_ = "", size_t budget_ = size_t(256) << 20) : dir(dir_), budget(budget_)
+    {
+        if( dir.size() == 0 )
+        {
+            const char* t = std::getenv("TMPDIR");
+            dir = (t != nullptr) ? std::string(t) : std::string("/tmp");
+        }
+        budget = std::max(budget,size_t(1) << 20);
+    }
+
+    // buffer of a sequential file: a small share of the budget
+    size_t buffer() const { return std::max<size_t>(budget/64,1 << 16); }
+};
+
+// file of records of type T: written with push_back, then read from the start with next
+template <typename T>
+class disk_vector
+{
+public:
+    disk_vector(const ext_config& cfg) : disk_vector(cfg.dir,cfg.buffer()){}
+    disk_vector(std::string dir, size_t buffer_bytes) : buf(std::max<size_t>(buffer_bytes/sizeof(T),1))
+    {
+        std::string name = dir + "/detwidth-XXXXXX";
+        int fd = mkstemp(&name[0]);
+        if( fd < 0 || (f = fdopen(fd,"w+b")) == nullptr )
+        {
+            std::cerr << "cannot create a temporary file in " << dir << "\n";
+            exit(1);
+        }
+        unlink(name.c_str());
+    }
+    ~disk_vector(){ if( f != nullptr ){ std::fclose(f); } }
+    disk_vector(const disk_vector&) = delete;
+    disk_vector& operator=(const disk_vector&) = delete;
+
+    void push_back(const T& x)
+    {
+        assert(writing);
+        buf[pos++] = x;
+        n++;
+        if( pos == buf.size() ){ flush(); }
+    }
+    size_t size() const { return n; }
+
+    // (re)start reading from the first record, optionally with a buffer of the given size
+    void rewind(size_t buffer_bytes = 0)
+    {
+        if( writing ){ flush(); writing = false; }
+        if( buffer_bytes > 0 )
+        {
+            buf.assign(std::max<size_t>(buffer_bytes/sizeof(T),1),T());
+            buf.shrink_to_fit();
+        }
+        std::fseek(f,0,SEEK_SET);
+        pos = len = 0;
+        read = 0;
+    }
+
+    // next record, false at the end
+    bool next(T& x)
+    {
+        assert(!writing);
+        if( pos == len )
+        {
+            if( read == n ){ return false; }
+            len = std::fread(buf.data(),sizeof(T),std::min(buf.size(),n-read),f);
+            pos = 0;
+            if( len == 0 ){ return false; }
+        }
+        x = buf[pos++];
+        read++;
+        return true;
+    }
+
+    // drop the records and start writing again
+    void clear()
+    {
+        std::fflush(f);
+        if( ftruncate(fileno(f),0) != 0 ){ std::cerr << "cannot truncate a temporary file\n"; exit(1); }
+        std::fseek(f,0,SEEK_SET);
+        writing = true;
+        pos = len = n = read = 0;
+    }
+
+private:
+    void flush()
+    {
+        if( pos > 0 && std::fwrite(buf.data(),sizeof(T),pos,f) != pos )
+        {
+            std::cerr << "cannot write a temporary file\n";
+            exit(1);
+        }
+        pos = 0;
+    }
+
+    std::FILE* f = nullptr;
+    std::vector<T> buf;
+    size_t pos = 0, len = 0, n = 0, read = 0;
+    bool writing = true;
+};
+
+/*
+    merge sort of records within the memory budget: the records are sorted in
+    runs filling half the budget, which are written to disk and merged with a
+    heap, reading every run through an equal share of the budget. If all the
+    records fit in one run they are never written.
+*/
+template <typename T, typename Less>
+class external_sorter
+{
+public:
+    external_sorter(const ext_config& cfg_, Less less_ = Less()) : cfg(cfg_), less(less_)
+    {
+        run_size = std::max<size_t>(cfg.budget/2/sizeof(T),1);
+    }
+    external_sorter(const external_sorter&) = delete;
+    external_sorter& operator=(const external_sorter&) = delete;
+
+    void push(const T& x)
+    {
+        if( mem.size() == run_size ){ spill(); }
+        mem.push_back(x);
+        n++;
+    }
+    size_t size() const { return n; }
+
+    // sort the records pushed so far; then read them in order with next
+    void sort()
+    {
+        std::sort(mem.begin(),mem.end(),less);
+        if( runs.empty() ){ pos = 0; return; }
+        if( mem.size() > 0 ){ spill(); }
+        mem.clear(); mem.shrink_to_fit();
+        // the merge reads each run with an equal share of the budget
+        heads.resize(runs.size());
+        size_t share = std::max<size_t>(cfg.budget/runs.size(),1 << 12);
+        for(size_t k=0;k<runs.size();++k)
+        {
+            runs[k]->rewind(share);
+            if( runs[k]->next(heads[k]) ){ heap.push(k); }
+        }
+    }
+
+    bool next(T& x)
+    {
+        if( runs.empty() )
+        {
+            if( pos == mem.size() ){ return false; }
+            x = mem[pos++];
+            return true;
+        }
+        if( heap.empty() ){ return false; }
+        size_t k = heap.top();
+        heap.pop();
+        x = heads[k];
+        if( runs[k]->next(heads[k]) ){ heap.push(k); }
+        return true;
+    }
+
+    // drop the records and start pushing again
+    void clear()
+    {
+        mem.clear();
+        runs.clear();
+        heads.clear();
+        heap = decltype(heap)(run_order{this});
+        n = pos = 0;
+    }
+
+private:
+    void spill()
+    {
+        std::sort(mem.begin(),mem.end(),less);
+        runs.emplace_back(new disk_vector<T>(cfg));
+        for(auto& x: mem){ runs.back()->push_back(x); }
+        // release the write buffer until the merge
+        runs.back()->rewind(sizeof(T));
+        mem.clear();
+    }
+
+    // heap order of the runs by their first record (smallest on top)
+    struct run_order
+    {
+        const external_sorter* s;
+        bool operator()(size_t a, size_t b) const { return s->less(s->heads[b],s->heads[a]); }
+    };
+
+    ext_config cfg;
+    Less less;
+    size_t run_size, n = 0, pos = 0;
+    std::vector<T> mem;
+    std::vector< std::unique_ptr< disk_vector<T> > > runs;
+    std::vector<T> heads;
+    std::priority_queue<size_t,std::vector<size_t>,run_order> heap{run_order{this}};
+};
+
+#endif
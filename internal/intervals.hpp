@@ -0,0 +1,149 @@
+#ifndef INTERVALS_HPP_
+#define INTERVALS_HPP_
+
+#include "automaton.hpp"
+
+// label code used by the interval computation; 0 is reserved for the empty string
+inline uint label_code(char label){ return uint(static_cast<unsigned char>(label)) + 1; }
+
+// keep for each state only the incoming edges with the minimum (max_dfa: maximum) label
+void prune_dfa(const DFA_edge_list& D, DFA_edge_list& min_dfa, DFA_edge_list& max_dfa)
+{
+    std::vector<uint> vmin(D.nodes, U_MAX);
+    std::vector<uint> vmax(D.nodes, 0);
+
+    for(auto& e: D.edges)
+    {
+        uint c = label_code(e.label);
+        if( vmin[e.dest] > c ){ vmin[e.dest] = c; }
+        if( vmax[e.dest] < c ){ vmax[e.dest] = c; }
+    }
+
+    min_dfa = DFA_edge_list();
+    max_dfa = DFA_edge_list();
+    min_dfa.nodes = max_dfa.nodes = D.nodes;
+    min_dfa.source = max_dfa.source = D.source;
+    min_dfa.accepting = max_dfa.accepting = D.accepting;
+
+    for(auto& e: D.edges)
+    {
+        uint c = label_code(e.label);
+        if( vmin[e.dest] == c ){ min_dfa.edges.push_back(e); }
+        if( vmax[e.dest] == c ){ max_dfa.edges.push_back(e); }
+    }
+}
+
+// dense ranks of the pairs (key1[i],key2[i]) with key1 < sigma1 and key2 < sigma2;
+// two counting sort passes, returns the number of distinct ranks
+uint rank_pairs(const std::vector<uint>& key1, const std::vector<uint>& key2, uint sigma1, uint sigma2,
+                std::vector<uint>& rank, std::vector<uint>& I, std::vector<uint>& I_)
+{
+    uint n = static_cast<uint>(key1.size());
+    std::vector<uint> C(std::max(sigma1,sigma2)+1,0);
+
+    // sort by second key
+    for(uint i=0;i<n;++i){ C[key2[i]+1]++; }
+    for(uint c=1;c<=sigma2;++c){ C[c] += C[c-1]; }
+    for(uint i=0;i<n;++i){ I_[C[key2[i]]++] = i; }
+    // stable sort by first key
+    std::fill(C.begin(),C.end(),0);
+    for(uint i=0;i<n;++i){ C[key1[i]+1]++; }
+    for(uint c=1;c<=sigma1;++c){ C[c] += C[c-1]; }
+    for(uint i=0;i<n;++i){ I[C[key1[I_[i]]]++] = I_[i]; }
+
+    // assign ranks
+    uint r = 0;
+    for(uint i=0;i<n;++i)
+    {
+        if( i > 0 && ( key1[I[i-1]] != key1[I[i]] || key2[I[i-1]] != key2[I[i]] ) ){ ++r; }
+        rank[I[i]] = r;
+    }
+    return (n > 0) ? r+1 : 0;
+}
+
+/*
+    co-lex ranks of the infimum and supremum strings of every state, computed by prefix
+    doubling on the two pruned graphs. Node 2v (2v+1) represents the infimum (supremum)
+    string of state v and equal strings get equal ranks; ptr holds, in CSR form, the
+    predecessors at distance 2^k spelling the current infimum (supremum) suffix.
+*/
+void compute_intervals(const DFA_edge_list& min_dfa, const DFA_edge_list& max_dfa,
+                       std::vector< std::pair<uint,uint> >& intervals)
+{
+    const uint V = min_dfa.nodes;
+    const uint N = 2*V;
+    std::vector<uint> R(N,0), R_(N), next(N), zero(N,0), I(N), I_(N);
+    std::vector<uint> off(N+1,0), ptr, off_(N+1), ptr_;
+
+    // initial ranks: incoming label of each node
+    for(auto& e: min_dfa.edges){ R[2*e.dest] = label_code(e.label); off[2*e.dest+1]++; }
+    for(auto& e: max_dfa.edges){ R[2*e.dest+1] = label_code(e.label); off[2*e.dest+2]++; }
+    uint r = rank_pairs(R,zero,257,1,R_,I,I_);
+    std::swap(R,R_);
+
+    // pointers to the predecessors
+    for(uint i=0;i<N;++i){ off[i+1] += off[i]; }
+    ptr.resize(off[N]);
+    {
+        std::vector<uint> pos(off.begin(),off.end()-1);
+        for(auto& e: min_dfa.edges){ ptr[pos[2*e.dest]++] = 2*e.origin; }
+        for(auto& e: max_dfa.edges){ ptr[pos[2*e.dest+1]++] = 2*e.origin+1; }
+    }
+
+    // rank of the best predecessor: minimum for infima, maximum for suprema; 0 if none
+    auto best_rank = [&](uint i, std::vector<uint>& Rank)
+    {
+        uint b = 0;
+        for(uint j=off[i];j<off[i+1];++j)
+        {
+            uint c = Rank[ptr[j]]+1;
+            if( b == 0 || ((i&0x1) ? (c > b) : (c < b)) ){ b = c; }
+        }
+        return b;
+    };
+
+    uint l = 1;
+    while( l < 2*N && r < N && ptr.size() > 0 )
+    {
+        // sort the nodes by the pairs of ranks
+        for(uint i=0;i<N;++i){ next[i] = best_rank(i,R); }
+        r = rank_pairs(R,next,r,r+1,R_,I,I_);
+        std::swap(R,R_);
+
+        // keep only the pointers to the best ranked predecessors
+        uint k = 0;
+        for(uint i=0;i<N;++i)
+        {
+            uint b = best_rank(i,R), beg = off[i];
+            off[i] = k;
+            for(uint j=beg;j<off[i+1];++j)
+                if( R[ptr[j]]+1 == b ){ ptr[k++] = ptr[j]; }
+        }
+        off[N] = k;
+        ptr.resize(k);
+
+        // update the pointers with the two hop predecessors
+        off_[0] = 0;
+        for(uint i=0;i<N;++i)
+        {
+            off_[i+1] = off_[i];
+            for(uint j=off[i];j<off[i+1];++j)
+                off_[i+1] += off[ptr[j]+1] - off[ptr[j]];
+        }
+        ptr_.resize(off_[N]);
+        for(uint i=0,k_=0;i<N;++i)
+            for(uint j=off[i];j<off[i+1];++j)
+                for(uint h=off[ptr[j]];h<off[ptr[j]+1];++h)
+                    ptr_[k_++] = ptr[h];
+        std::swap(off,off_);
+        std::swap(ptr,ptr_);
+
+        l <<= 1;
+    }
+
+    intervals.resize(V);
+    for(uint v=0;v<V;++v)
+        intervals[v] = std::make_pair(R[2*v],R[2*v+1]);
+}
+
+#endif
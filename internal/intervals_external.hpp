@@ -0,0 +1,265 @@
+#ifndef INTERVALS_EXTERNAL_HPP_
+#define INTERVALS_EXTERNAL_HPP_
+
+#include "automaton.hpp"
+#include "utils.hpp"
+#include "intervals.hpp"
+#include "external.hpp"
+
+/*
+    external memory version of prune_dfa and compute_intervals for DFAs larger
+    than the memory: the DFA file is read sequentially, every per-state array is
+    a file read in state order and the pointer updates of the prefix doubling
+    are joins done by external sorting. Two sorters are alive at the same time,
+    so each gets half of the memory budget.
+*/
+
+// pair of states (or of a state and a value); ordered by first, then second
+struct ext_pair
+{
+    uint first, second;
+    bool operator<(const ext_pair& o) const
+    {
+        return first < o.first || ( first == o.first && second < o.second );
+    }
+};
+
+// transition dest <- origin with label code (label_code); ordered by dest, code and origin
+struct ext_edge
+{
+    uint dest, code, origin;
+    bool operator<(const ext_edge& o) const
+    {
+        if( dest != o.dest ){ return dest < o.dest; }
+        if( code != o.code ){ return code < o.code; }
+        return origin < o.origin;
+    }
+};
+
+// triple (key1,key2,node) ordered by the keys
+struct ext_triple
+{
+    uint key1, key2, node;
+};
+
+struct ext_less
+{
+    template <typename T>
+    bool operator()(const T& a, const T& b) const { return a < b; }
+};
+
+struct ext_key_less
+{
+    bool operator()(const ext_triple& a, const ext_triple& b) const
+    {
+        return a.key1 < b.key1 || ( a.key1 == b.key1 && a.key2 < b.key2 );
+    }
+};
+
+/*
+    prune the DFA in input_file with one external sort of its transitions by
+    destination: emit(max,origin,code,dest) is called for the transitions of
+    the min (max false) and max (max true) pruned graphs, by increasing
+    destination, and final_state(s) for the accepting states. The transitions
+    with the maximum label entering a state are buffered until its last one.
+*/
+template <typename Final, typename Emit>
+void prune_dfa_external(std::string input_file, const ext_config& cfg, dfa_header& h, Final final_state, Emit emit)
+{
+    ext_config half(cfg.dir,cfg.budget/2);
+    external_sorter<ext_edge,ext_less> S(half);
+    scan_dfa(input_file,h,[&](uint origin, char label, uint dest){ S.push({dest,label_code(label),origin}); },final_state);
+    S.sort();
+
+    ext_edge e;
+    std::vector<ext_edge> run;
+    bool more = S.next(e);
+    while( more )
+    {
+        uint dest = e.dest, min_code = e.code;
+        run.clear();
+        while( more && e.dest == dest )
+        {
+            if( e.code == min_code ){ emit(false,e.origin,e.code,e.dest); }
+            if( !run.empty() && run.back().code != e.code ){ run.clear(); }
+            run.push_back(e);
+            more = S.next(e);
+        }
+        for(auto& m: run){ emit(true,m.origin,m.code,m.dest); }
+    }
+}
+
+/*
+    co-lex ranks of the infimum and supremum strings of every state of the DFA in
+    input_file, as compute_intervals on its pruned graphs; out(v,inf,sup) is
+    called for every state v in order
+*/
+template <typename Out>
+void compute_intervals_external(std::string input_file, const ext_config& cfg, Out out)
+{
+    ext_config half(cfg.dir,cfg.budget/2);
+    typedef disk_vector<uint> disk_ranks;
+    typedef disk_vector<ext_pair> disk_pairs;
+
+    // initial ranks (incoming label of each node, by node) and pointers to the
+    // predecessors in the pruned graphs (by node)
+    std::unique_ptr<disk_ranks> R(new disk_ranks(cfg)), R_(new disk_ranks(cfg));
+    std::unique_ptr<disk_pairs> ptr(new disk_pairs(cfg));
+    std::vector<bool> used(258,false);
+    dfa_header h;
+    // node whose incoming code is pending, and first node without a rank
+    uint cur = U_MAX, code = 0, node = 0;
+    auto close_node = [&](uint end)
+    {
+        if( cur != U_MAX ){ R->push_back(code); used[code] = true; node = cur+1; cur = U_MAX; }
+        for(;node<end;++node){ R->push_back(0); used[0] = true; }
+    };
+    prune_dfa_external(input_file,cfg,h,[](uint){},[&](bool max, uint origin, uint c, uint dest)
+    {
+        uint i = 2*dest + (max ? 1 : 0);
+        if( i != cur ){ close_node(i); cur = i; code = c; }
+        ptr->push_back({i,2*origin + (max ? 1 : 0)});
+    });
+    const uint N = static_cast<uint>(2*h.nodes);
+    close_node(N);
+
+    // dense ranks of the label codes
+    std::vector<uint> rank_of(258,0);
+    uint r = 0;
+    for(uint c=0;c<258;++c)
+        if( used[c] ){ rank_of[c] = r++; }
+    R->rewind();
+    for(uint x;R->next(x);){ R_->push_back(rank_of[x]); }
+    std::swap(R,R_);
+    R->rewind();
+
+    // predecessor pointers sorted by the predecessor: ptr_by_j holds pairs (j,i)
+    auto by_predecessor = [&](disk_pairs& P, disk_pairs& by_j)
+    {
+        external_sorter<ext_pair,ext_less> S(half);
+        ext_pair p;
+        P.rewind();
+        while( P.next(p) ){ S.push({p.second,p.first}); }
+        S.sort();
+        by_j.clear();
+        while( S.next(p) ){ by_j.push_back(p); }
+        by_j.rewind();
+    };
+    // scan pairs (j,x) sorted by j together with the ranks: f(j,x,Rank[j])
+    auto join_ranks = [&](disk_pairs& by_j, disk_ranks& Rank, auto f)
+    {
+        ext_pair p;
+        uint j = 0, rj = 0;
+        by_j.rewind(); Rank.rewind();
+        Rank.next(rj);
+        while( by_j.next(p) )
+        {
+            for(;j<p.first;++j){ Rank.next(rj); }
+            f(p.first,p.second,rj);
+        }
+    };
+
+    std::unique_ptr<disk_pairs> by_j(new disk_pairs(cfg));
+    uint l = 1;
+    while( l < 2*N && r < N && ptr->size() > 0 )
+    {
+        by_predecessor(*ptr,*by_j);
+
+        // rank of the best predecessor of every node: minimum for infima, maximum for suprema; 0 if none
+        disk_ranks next(cfg);
+        {
+            external_sorter<ext_pair,ext_less> S(half);
+            join_ranks(*by_j,*R,[&](uint, uint i, uint rj){ S.push({i,rj+1}); });
+            S.sort();
+            ext_pair p;
+            uint i = 0, b = 0;
+            bool any = false;
+            while( S.next(p) )
+            {
+                for(;i<p.first;++i){ next.push_back(any ? b : 0); any = false; }
+                uint c = p.second;
+                if( !any || ((i&0x1) ? (c > b) : (c < b)) ){ b = c; }
+                any = true;
+            }
+            for(;i<N;++i){ next.push_back(any ? b : 0); any = false; }
+        }
+
+        // sort the nodes by the pairs of ranks
+        {
+            external_sorter<ext_triple,ext_key_less> S(half);
+            R->rewind(); next.rewind();
+            uint x, y;
+            for(uint i=0;R->next(x) && next.next(y);++i){ S.push({x,y,i}); }
+            S.sort();
+            external_sorter<ext_pair,ext_less> T(half);
+            ext_triple t, prev = {0,0,0};
+            r = 0;
+            for(bool first=true;S.next(t);first=false)
+            {
+                if( !first && ( t.key1 != prev.key1 || t.key2 != prev.key2 ) ){ ++r; }
+                T.push({t.node,r});
+                prev = t;
+            }
+            r = (N > 0) ? r+1 : 0;
+            T.sort();
+            R_->clear();
+            ext_pair p;
+            while( T.next(p) ){ R_->push_back(p.second); }
+            std::swap(R,R_);
+        }
+
+        // keep only the pointers to the best ranked predecessors: sort the pointers of
+        // every node from the best one and keep the ones as good as the first
+        {
+            auto best_first = [](const ext_triple& a, const ext_triple& b)
+            {
+                if( a.key1 != b.key1 ){ return a.key1 < b.key1; }
+                return (a.key1&0x1) ? (a.key2 > b.key2) : (a.key2 < b.key2);
+            };
+            external_sorter<ext_triple,decltype(best_first)> S(half,best_first);
+            join_ranks(*by_j,*R,[&](uint j, uint i, uint rj){ S.push({i,rj+1,j}); });
+            S.sort();
+            ptr->clear();
+            ext_triple t, prev = {U_MAX,0,0};
+            while( S.next(t) )
+            {
+                if( t.key1 != prev.key1 ){ prev = t; }
+                if( t.key2 == prev.key2 ){ ptr->push_back({t.key1,t.node}); }
+            }
+        }
+
+        // update the pointers with the two hop predecessors: join the pointers (j,i),
+        // sorted by j, with the pointers (j,h) of j
+        by_predecessor(*ptr,*by_j);
+        {
+            external_sorter<ext_pair,ext_less> S(half);
+            // predecessors of node j
+            std::vector<uint> hops;
+            uint j = U_MAX;
+            ext_pair a, b;
+            ptr->rewind();
+            bool more = ptr->next(b);
+            while( by_j->next(a) )
+            {
+                if( a.first != j )
+                {
+                    j = a.first;
+                    hops.clear();
+                    while( more && b.first < j ){ more = ptr->next(b); }
+                    while( more && b.first == j ){ hops.push_back(b.second); more = ptr->next(b); }
+                }
+                for(auto h_: hops){ S.push({a.second,h_}); }
+            }
+            S.sort();
+            ptr->clear();
+            while( S.next(a) ){ ptr->push_back(a); }
+        }
+
+        l <<= 1;
+    }
+
+    R->rewind();
+    for(uint v=0,x,y;v<h.nodes && R->next(x) && R->next(y);++v){ out(v,x,y); }
+}
+
+#endif
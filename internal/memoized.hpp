@@ -0,0 +1,242 @@
+#ifndef MEMOIZED_HPP_
+#define MEMOIZED_HPP_
+
+#include <unordered_map>
+#include "automaton.hpp"
+#include "utils.hpp"
+#include "minimize.hpp"
+#include "intervals.hpp"
+#include "width.hpp"
+// canonical minimum DFA and width bounds
+#include "cache.hpp"
+
+/*
+    width queries on a DFA changing by a few transitions at a time, memoizing the
+    results of the language. The state is the input DFA, its canonical minimum
+    DFA (see cache.hpp), the intervals, the known bounds on the width and a cycle
+    of A^lo witnessing the lower bound. An update applies the delta to the input
+    DFA and minimizes it from scratch, then:
+    - if the canonical minimum DFA is unchanged, the language is the same and
+      all the results are kept;
+    - otherwise everything else is recomputed from scratch as for a new DFA: the
+      intervals, and the L lists and A^p of the next queries. Only the witness
+      is carried over, mapped on the new minimum DFA through the input states of
+      its tuples: if it is still a cycle of A^lo the lower bound is kept, so the
+      next queries only probe the larger p.
+    Nothing is updated in place, so an update costs at least a minimization, and
+    a full recomputation whenever the language changes.
+*/
+
+// change of the transitions of the input DFA; the removals are applied first
+struct edge_delta
+{
+    std::vector<transition> added, removed;
+
+    bool empty() const { return added.empty() && removed.empty(); }
+};
+
+class memoized_width
+{
+public:
+
+    // what the last update recomputed
+    struct update_info
+    {
+        // the minimum DFA changed (otherwise nothing is recomputed)
+        bool min_changed = false;
+        // the witness cycle survived the change (the lower bound is kept)
+        bool witness_kept = false;
+        // lower bound kept by the update
+        uint lo = 1;
+        double time = 0;
+    };
+
+    memoized_width(const DFA_edge_list& D_) : D(D_)
+    {
+        rebuild();
+    }
+
+    void set_threads(uint threads_){ threads = threads_; }
+    void set_cycle_algorithm(cycle_algorithm algo_){ algo = algo_; }
+
+    /*
+        apply the delta to the input DFA. Returns false and leaves the state
+        unchanged if a removed transition is missing or an added one would make
+        the DFA nondeterministic; the states of the added transitions may be new
+    */
+    bool update(const edge_delta& delta, std::string& error)
+    {
+        stopwatch sw;
+        DFA_edge_list E(D);
+        // position of the transition leaving each (state,label)
+        std::unordered_map<uint64_t,size_t> pos;
+        auto key = [](uint origin, char label)
+        {
+            return (uint64_t(origin) << 8) | static_cast<unsigned char>(label);
+        };
+        for(size_t i=0;i<E.edges.size();++i){ pos[key(E.edges[i].origin,E.edges[i].label)] = i; }
+
+        std::vector<bool> gone(E.edges.size(),false);
+        for(auto& t: delta.removed)
+        {
+            auto it = pos.find(key(t.origin,t.label));
+            if( it == pos.end() || gone[it->second] || E.edges[it->second].dest != t.dest )
+            {
+                error = "missing transition " + edge_string(t);
+                return false;
+            }
+            gone[it->second] = true;
+            pos.erase(it);
+        }
+        size_t k = 0;
+        for(size_t i=0;i<E.edges.size();++i)
+            if( !gone[i] ){ E.edges[k++] = E.edges[i]; }
+        E.edges.resize(k);
+        for(auto& t: delta.added)
+        {
+            if( !pos.insert({key(t.origin,t.label),E.edges.size()}).second )
+            {
+                error = "nondeterministic transition " + edge_string(t);
+                return false;
+            }
+            E.edges.push_back(t);
+            E.nodes = std::max({E.nodes,t.origin+1,t.dest+1});
+        }
+
+        D = std::move(E);
+        rebuild();
+        info.time = sw.elapsed();
+        return true;
+    }
+
+    // exact width of the language
+    uint width()
+    {
+        if( b.exact() ){ return b.lo; }
+        width_checker W(M,intervals);
+        setup(W);
+        uint w = W.exact_width(false,b.lo,b.hi);
+        b.set_exact(w);
+        // keep the cycle of A^w found by the search as the witness of the new lower bound
+        if( w > witness_p && w >= 2 ){ keep_witness(W,w); }
+        return w;
+    }
+
+    // true if the width is smaller than p (p = 2: the language is Wheeler)
+    bool width_lt(uint p)
+    {
+        if( p < 2 ){ return false; }
+        int a = b.answer(p);
+        if( a >= 0 ){ return a == 1; }
+        width_checker W(M,intervals);
+        setup(W);
+        bool cyclic = (p == 2) ? W.find_cycle_pairs() : W.find_cycle(p);
+        b.add(p,cyclic);
+        if( cyclic && p > witness_p ){ keep_witness(W,p); }
+        return !cyclic;
+    }
+
+    const width_bounds& bounds() const { return b; }
+    const update_info& last_update() const { return info; }
+    // canonical minimum DFA and its intervals
+    const DFA_edge_list& minimum() const { return C; }
+    const std::vector< std::pair<uint,uint> >& get_intervals() const { return intervals; }
+
+private:
+
+    static std::string edge_string(const transition& t)
+    {
+        return std::to_string(t.origin) + " " + std::to_string(uint(static_cast<unsigned char>(t.label))) +
+               " " + std::to_string(t.dest);
+    }
+
+    void setup(width_checker& W)
+    {
+        W.set_threads(threads);
+        W.set_cycle_algorithm(algo);
+        W.set_witness(true);
+    }
+
+    // keep the cycle of A^p found by the last check of W
+    void keep_witness(width_checker& W, uint p)
+    {
+        if( W.witness().empty() ){ return; }
+        witness = W.witness();
+        witness_p = p;
+    }
+
+    // minimize the input DFA and, if the minimum DFA changed, recompute the rest
+    void rebuild()
+    {
+        // an input state of every class of the old minimum DFA, to map the witness
+        std::vector<uint> rep(C.nodes,U_MAX);
+        for(uint q=0;q<cls.size();++q)
+            if( cls[q] != U_MAX && rep[cls[q]] == U_MAX ){ rep[cls[q]] = q; }
+
+        DFA_edge_list D_min, C_new;
+        std::vector<uint> cls_min, ids;
+        minimize_dfa(D,D_min,cls_min);
+        canonical_dfa(D_min,C_new,&ids);
+        cls.assign(D.nodes,U_MAX);
+        for(uint q=0;q<D.nodes;++q)
+            if( cls_min[q] != U_MAX ){ cls[q] = ids[cls_min[q]]; }
+
+        info = update_info();
+        if( C.nodes > 0 && result_cache::same_dfa(C,C_new) )
+        {
+            info.witness_kept = !witness.empty();
+            info.lo = b.lo;
+            return;
+        }
+        info.min_changed = true;
+        C = std::move(C_new);
+
+        DFA_edge_list D_prmin, D_prmax;
+        prune_dfa(C,D_prmin,D_prmax);
+        intervals.clear();
+        compute_intervals(D_prmin,D_prmax,intervals);
+        M = min_dfa(C);
+        b = width_bounds();
+        b.hi = std::max<uint>(C.nodes,1);
+
+        // map the witness on the new minimum DFA and check it
+        std::vector<uint> mapped;
+        for(auto s: witness)
+        {
+            uint q = (s < rep.size()) ? rep[s] : U_MAX;
+            if( q == U_MAX || cls[q] == U_MAX ){ mapped.clear(); break; }
+            mapped.push_back(cls[q]);
+        }
+        width_checker W(M,intervals);
+        if( !mapped.empty() && W.is_cycle(mapped,witness_p) )
+        {
+            witness = mapped;
+            b.lo = witness_p;
+            info.witness_kept = true;
+        }
+        else
+        {
+            witness.clear();
+            witness_p = 0;
+        }
+        info.lo = b.lo;
+    }
+
+    // input DFA and class of every input state in C
+    DFA_edge_list D;
+    std::vector<uint> cls;
+    // canonical minimum DFA, its intervals and the DFA used by the checks
+    DFA_edge_list C;
+    std::vector< std::pair<uint,uint> > intervals;
+    min_dfa M;
+    // bounds on the width and cycle of A^witness_p (tuples of states of C)
+    width_bounds b;
+    std::vector<uint> witness;
+    uint witness_p = 0;
+
+    uint threads = 1;
+    cycle_algorithm algo = DFS_CYCLE;
+    update_info info;
+};
+
+#endif
@@ -0,0 +1,226 @@
+#ifndef MINIMIZE_HPP_
+#define MINIMIZE_HPP_
+
+#include <algorithm>
+#include "automaton.hpp"
+
+/*
+    DFA minimization for partial transition functions in O(m log n) time;
+    A. Valmari, P. Lehtinen: Efficient minimization of DFAs with partial
+    transition functions. STACS 2008.
+*/
+class DFA_minimizer
+{
+public:
+
+    DFA_minimizer(const DFA_edge_list& D) : nn(D.nodes), mm(static_cast<uint>(D.edges.size())), rr(0)
+    {
+        T.resize(mm); L.resize(mm); H.resize(mm);
+        for(uint t=0;t<mm;++t)
+        {
+            T[t] = D.edges[t].origin;
+            L[t] = D.edges[t].label;
+            H[t] = D.edges[t].dest;
+        }
+        B.init(nn);
+        A.resize(mm);
+        F.resize(nn+1);
+
+        // remove states that cannot be reached from the source
+        // and states from which accepting states cannot be reached
+        reach(D.source);
+        remove_unreachable(T,H);
+        for(auto& q: D.accepting)
+            if( B.L[q] < B.P[0] ){ reach(q); }
+        ff = rr;
+        remove_unreachable(H,T);
+        q0 = D.source;
+    }
+
+    // compute the minimum DFA
+    void minimize(DFA_edge_list& out)
+    {
+        kept = B.P[0];
+        // empty language
+        if( B.P[0] == 0 || B.L[q0] >= B.P[0] )
+        {
+            out = DFA_edge_list();
+            out.nodes = 1;
+            return;
+        }
+
+        // initial partition: accepting and non accepting states
+        W.assign(std::max(mm,nn)+1,0); M.assign(std::max(mm,nn)+1,0);
+        w = 0; M[0] = ff;
+        if( ff ){ W[w++] = 0; B.split(M,W,w); }
+
+        // transition partition by label
+        C.init(mm);
+        if( mm )
+        {
+            std::sort(C.E.begin(),C.E.end(),[&](uint i, uint j){ return L[i] < L[j]; });
+            C.z = M[0] = 0;
+            char a = L[C.E[0]];
+            for(uint i=0;i<mm;++i)
+            {
+                uint t = C.E[i];
+                if( L[t] != a )
+                {
+                    a = L[t];
+                    C.P[C.z++] = i;
+                    C.F[C.z] = i;
+                    M[C.z] = 0;
+                }
+                C.S[t] = C.z;
+                C.L[t] = i;
+            }
+            C.P[C.z++] = mm;
+        }
+
+        // split blocks and cords
+        make_adjacent(H);
+        uint b = 1, c = 0;
+        while( c < C.z )
+        {
+            for(uint i=C.F[c];i<C.P[c];++i)
+                B.mark(T[C.E[i]],M,W,w);
+            B.split(M,W,w); ++c;
+            while( b < B.z )
+            {
+                for(uint i=B.F[b];i<B.P[b];++i)
+                    for(uint j=F[B.E[i]];j<F[B.E[i]+1];++j)
+                        C.mark(A[j],M,W,w);
+                C.split(M,W,w); ++b;
+            }
+        }
+
+        // build the minimum DFA; one representative state per block
+        out = DFA_edge_list();
+        out.nodes = B.z;
+        out.source = B.S[q0];
+        for(uint t=0;t<mm;++t)
+            if( B.L[T[t]] == B.F[B.S[T[t]]] )
+                out.add_edge(B.S[T[t]],L[t],B.S[H[t]]);
+        for(uint b_=0;b_<B.z;++b_)
+            if( B.F[b_] < ff )
+                out.accepting.push_back(b_);
+    }
+
+    // state of the minimum DFA equivalent to every state of the input DFA, U_MAX for
+    // the removed ones (unreachable or not reaching an accepting state); call after
+    // minimize
+    void classes(std::vector<uint>& cls)
+    {
+        cls.assign(nn,U_MAX);
+        if( kept == 0 || B.L[q0] >= kept ){ return; }
+        for(uint q=0;q<nn;++q)
+            if( B.L[q] < kept ){ cls[q] = B.S[q]; }
+    }
+
+private:
+
+    // refinable partition
+    struct partition
+    {
+        uint z;
+        std::vector<uint> E, L, S, F, P;
+
+        void init(uint n)
+        {
+            z = (n > 0);
+            E.resize(n); L.resize(n); S.assign(n,0);
+            F.assign(n+1,0); P.assign(n+1,0);
+            for(uint i=0;i<n;++i){ E[i] = L[i] = i; }
+            if( z ){ P[0] = n; }
+        }
+
+        void mark(uint e, std::vector<uint>& M, std::vector<uint>& W, uint& w)
+        {
+            uint s = S[e], i = L[e], j = F[s]+M[s];
+            E[i] = E[j]; L[E[i]] = i;
+            E[j] = e; L[e] = j;
+            if( !M[s]++ ){ W[w++] = s; }
+        }
+
+        void split(std::vector<uint>& M, std::vector<uint>& W, uint& w)
+        {
+            while( w )
+            {
+                uint s = W[--w], j = F[s]+M[s];
+                if( j == P[s] ){ M[s] = 0; continue; }
+                if( M[s] <= P[s]-j ){ F[z] = F[s]; P[z] = F[s] = j; }
+                else{ P[z] = P[s]; F[z] = P[s] = j; }
+                for(uint i=F[z];i<P[z];++i){ S[E[i]] = z; }
+                M[s] = M[z++] = 0;
+            }
+        }
+    };
+
+    // sort transitions by the states in K
+    void make_adjacent(const std::vector<uint>& K)
+    {
+        for(uint q=0;q<=nn;++q){ F[q] = 0; }
+        for(uint t=0;t<mm;++t){ ++F[K[t]]; }
+        for(uint q=0;q<nn;++q){ F[q+1] += F[q]; }
+        for(uint t=mm;t--;){ A[--F[K[t]]] = t; }
+    }
+
+    void reach(uint q)
+    {
+        uint i = B.L[q];
+        if( i >= rr )
+        {
+            B.E[i] = B.E[rr]; B.L[B.E[i]] = i;
+            B.E[rr] = q; B.L[q] = rr++;
+        }
+    }
+
+    void remove_unreachable(std::vector<uint>& K, std::vector<uint>& G)
+    {
+        make_adjacent(K);
+        for(uint i=0;i<rr;++i)
+            for(uint j=F[B.E[i]];j<F[B.E[i]+1];++j)
+                reach(G[A[j]]);
+        uint j = 0;
+        for(uint t=0;t<mm;++t)
+        {
+            if( B.L[K[t]] < rr )
+            {
+                G[j] = G[t]; L[j] = L[t]; K[j] = K[t]; ++j;
+            }
+        }
+        mm = j; B.P[0] = rr; rr = 0;
+    }
+
+    // number of states, transitions, reached states, accepting states and source
+    uint nn, mm, rr, ff = 0, q0 = 0;
+    // states kept by the removal of the useless ones
+    uint kept = 0;
+    // transitions: tail, label, head
+    std::vector<uint> T, H;
+    std::vector<char> L;
+    // adjacency of states
+    std::vector<uint> A, F;
+    // blocks and cords
+    partition B, C;
+    // marked counters and worklist
+    std::vector<uint> M, W;
+    uint w = 0;
+};
+
+// compute the minimum DFA of D
+void minimize_dfa(const DFA_edge_list& D, DFA_edge_list& out)
+{
+    DFA_minimizer m(D);
+    m.minimize(out);
+}
+
+// as above; cls[q] is the state of out equivalent to state q of D (see classes)
+void minimize_dfa(const DFA_edge_list& D, DFA_edge_list& out, std::vector<uint>& cls)
+{
+    DFA_minimizer m(D);
+    m.minimize(out);
+    m.classes(cls);
+}
+
+#endif
@@ -0,0 +1,68 @@
+#ifndef PARALLEL_HPP_
+#define PARALLEL_HPP_
+
+#include <thread>
+#include <vector>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include "automaton.hpp"
+
+// run f(i) for i in [0,threads), on threads-1 new threads and on the calling one
+template <typename F>
+void parallel_run(uint threads, F f)
+{
+    std::vector<std::thread> pool;
+    for(uint i=1;i<threads;++i)
+        pool.emplace_back([&f,i](){ f(i); });
+    f(0);
+    for(auto& t: pool){ t.join(); }
+}
+
+// run f(k) for every k in [0,n) on threads threads; the items are handed out
+// one at a time, so they should be coarse enough to amortize the counter
+template <typename F>
+void parallel_for(uint threads, size_t n, F f)
+{
+    // not worth starting threads
+    if( threads <= 1 || n <= 1 )
+    {
+        for(size_t k=0;k<n;++k){ f(k); }
+        return;
+    }
+    std::atomic<size_t> next(0);
+    parallel_run(threads,[&](uint)
+    {
+        for(size_t k=next++;k<n;k=next++){ f(k); }
+    });
+}
+
+// reusable barrier of the threads of a parallel_run: wait() returns when all of
+// them have called it
+class thread_barrier
+{
+public:
+    thread_barrier(uint threads_) : threads(threads_){}
+
+    void wait()
+    {
+        std::unique_lock<std::mutex> lock(m);
+        size_t g = generation;
+        if( ++arrived == threads )
+        {
+            arrived = 0;
+            generation++;
+            cv.notify_all();
+            return;
+        }
+        cv.wait(lock,[&](){ return generation != g; });
+    }
+
+private:
+    std::mutex m;
+    std::condition_variable cv;
+    uint threads, arrived = 0;
+    size_t generation = 0;
+};
+
+#endif
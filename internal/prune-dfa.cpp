@@ -9,147 +9,226 @@
 #include <stack>
 #include <fstream>
 #include <sstream>
-
-void tokenize(std::string const &str, const char delim, 
-            std::vector<std::string> &out) 
-{ 
-    // construct a stream from the string 
-    std::stringstream ss(str); 
-
-    // clear out vector
-    out.clear();
-    
-    // segment str using delim
-    std::string s; 
-    while (std::getline(ss, s, delim)) { 
-        out.push_back(s); 
-    } 
-}
-
-// simple parser for intermediate file; it reads line by line origin \t destination \t label \n
-void prune_dfa(std::string input_file, std::string min_dfa_file, std::string max_dfa_file)
+#include <unistd.h>
+// binary file format
+#include "binary.hpp"
+// buffered text parser
+#include "text_reader.hpp"
+// streaming DFA reader
+#include "utils.hpp"
+// external memory pruning
+#include "intervals_external.hpp"
+
+// pruned graph output: text (origin destination label per line, header last) or binary;
+// the binary arrays are written to temporary files until the counts are known
+class pruned_writer
 {
-    // open stream to input
-    std::ifstream input(input_file);
-    std::string line;
-    const char delim = ' '; 
-    size_t nodes, edges, source, accepting, dest;
-    char label;
-    std::vector<std::string> out; 
+public:
+    pruned_writer(std::string file_, bool binary_, const ext_config& cfg = ext_config()) : file(file_), binary(binary_)
+    {
+        if( !binary ){ out.open(file); return; }
+        origin.reset(new disk_vector<uint32_t>(cfg));
+        dest.reset(new disk_vector<uint32_t>(cfg));
+        label.reset(new disk_vector<char>(cfg));
+        final_states.reset(new disk_vector<uint32_t>(cfg));
+    }
+
+    // write transition (origin,dest) with label; labels up to 36 are shifted by 36
+    void add(size_t origin_, size_t dest_, char label_)
+    {
+        char c = (label_ <= 36) ? char(label_+36) : label_;
+        if( binary )
+        {
+            origin->push_back(origin_);
+            dest->push_back(dest_);
+            label->push_back(c);
+        }
+        else{ out << origin_ << " " << dest_ << " " << c << "\n"; }
+        edges++;
+    }
 
-    std::getline(input, line);
-    tokenize(line, delim, out);
+    // accepting state, kept by the binary format only
+    void final_state(size_t s)
+    {
+        if( binary ){ final_states->push_back(s); }
+        accepting++;
+    }
 
-    assert(out.size() == 4);
+    void close(size_t nodes, size_t source)
+    {
+        if( binary )
+        {
+            out.open(file, std::ios::binary);
+            bin_write_header(out,BIN_PRUNED,{nodes,edges,source,accepting});
+            copy(*origin); copy(*dest); copy(*label); copy(*final_states);
+        }
+        else{ out << nodes << " " <<  edges << " " << source << " " << accepting << "\n"; }
+        out.close();
+    }
 
-    nodes = std::stoull(out[0]);
-    edges = std::stoull(out[1]);
-    source = std::stoull(out[2]);
-    accepting = std::stoull(out[3]);
+private:
+    // append a temporary array to the output, padded as bin_write_array
+    template <typename T>
+    void copy(disk_vector<T>& a)
+    {
+        const char zero[8] = {0,0,0,0,0,0,0,0};
+        T x;
+        a.rewind();
+        while( a.next(x) ){ out.write(reinterpret_cast<const char*>(&x),sizeof(T)); }
+        out.write(zero,bin_padded(a.size(),sizeof(T))-a.size()*sizeof(T));
+    }
 
+    std::string file;
+    bool binary;
+    std::ofstream out;
+    std::unique_ptr< disk_vector<uint32_t> > origin, dest, final_states;
+    std::unique_ptr< disk_vector<char> > label;
+    size_t edges = 0, accepting = 0;
+};
+
+// keep the transitions with the smallest and the largest label entering each state,
+// in one pass over the transitions of D
+void prune_dfa(const dfa_view& D, std::string min_dfa_file, std::string max_dfa_file, bool binary_out)
+{
     #ifdef VERBOSE
     {
-        std::cout << "Nodes: " << nodes << "\n";
-        std::cout << "Edges: " << edges << "\n";
-        std::cout << "Source: " << source << "\n";
-        std::cout << "No. acc. states: " << accepting << "\n";
+        std::cout << "Nodes: " << D.nodes << "\n";
+        std::cout << "Edges: " << D.edges << "\n";
+        std::cout << "Source: " << D.source << "\n";
+        std::cout << "No. acc. states: " << D.accepting << "\n";
     }
     #endif
-    
-    std::vector<char> vmin(nodes, 127);
-    std::vector<char> vmax(nodes, 0);
 
-    for(size_t i=0;i<edges;++i)
+    std::vector<char> vmin(D.nodes, 127);
+    std::vector<char> vmax(D.nodes, 0);
+    for(size_t i=0;i<D.edges;++i)
     {
-        std::getline(input, line);
-        tokenize(line, delim, out);
-
-        assert(out.size() == 3);
-        
-        dest = std::stoull(out[2]);
-        label = std::stoull(out[1]);
-
-        if( vmin[dest] > label ){ vmin[dest] = label; }
-        if( vmax[dest] < label ){ vmax[dest] = label; }
+        char label = char(D.label[i]);
+        if( vmin[D.dest[i]] > label ){ vmin[D.dest[i]] = label; }
+        if( vmax[D.dest[i]] < label ){ vmax[D.dest[i]] = label; }
     }
 
-    input.clear();                
-    input.seekg(0, std::ios::beg); 
+    pruned_writer min_dfa(min_dfa_file,binary_out), max_dfa(max_dfa_file,binary_out);
+    for(size_t i=0;i<D.edges;++i)
+    {
+        char label = char(D.label[i]);
+        if( vmin[D.dest[i]] == label ){ min_dfa.add(D.origin[i],D.dest[i],label); }
+        if( vmax[D.dest[i]] == label ){ max_dfa.add(D.origin[i],D.dest[i],label); }
+    }
+    for(size_t i=0;i<D.accepting;++i)
+    {
+        min_dfa.final_state(D.final_states[i]);
+        max_dfa.final_state(D.final_states[i]);
+    }
+    min_dfa.close(D.nodes,D.source);
+    max_dfa.close(D.nodes,D.source);
+}
 
-    std::ofstream min_dfa;
-    std::ofstream max_dfa;
+// prune a binary DFA: the transitions are read in place from the mapped file
+void prune_dfa_binary(std::string input_file, std::string min_dfa_file, std::string max_dfa_file, bool binary_out)
+{
+    mapped_file f(input_file);
+    prune_dfa(map_dfa(f,input_file),min_dfa_file,max_dfa_file,binary_out);
+}
 
-    min_dfa.open(min_dfa_file);
-    max_dfa.open(max_dfa_file);
+// prune a text DFA: the transitions are parsed once into arrays laid out as in the binary format
+void prune_dfa(std::string input_file, std::string min_dfa_file, std::string max_dfa_file, bool binary_out)
+{
+    text_reader input(input_file);
+    uint64_t x[4];
+    size_t fields = input.read_line(x,4);
+    assert(fields == 4);
 
-    size_t edge_min = 0; 
-    size_t edge_max = 0;
+    dfa_view D;
+    D.nodes = x[0]; D.edges = x[1]; D.source = x[2]; D.accepting = x[3];
+    std::vector<uint32_t> origin(D.edges), dest(D.edges), final_states(D.accepting,0);
+    std::vector<unsigned char> label(D.edges);
 
-    std::getline(input, line);
-    for(size_t i=0;i<edges;++i)
+    for(size_t i=0;i<D.edges;++i)
     {
-        std::getline(input, line);
-        tokenize(line, delim, out);
+        fields = input.read_line(x,3);
+        assert(fields == 3);
 
-        assert(out.size() == 3);
-
-        dest = std::stoull(out[2]);
-        label = std::stoull(out[1]);
-
-        if( vmin[dest] == label )
-        { 
+        origin[i] = x[0];
+        label[i] = static_cast<unsigned char>(x[1]);
+        dest[i] = x[2];
+    }
+    // accepting states, kept by the binary format only
+    for(size_t i=0;i<D.accepting && input.read_line(x,1) == 1;++i)
+        final_states[i] = x[0];
+    (void)fields;
 
-            if( label <= 36 )
-            {
-                min_dfa << std::stoull(out[0]) << " " << dest << " " <<  char(label+36) << "\n";
-            }
-            else{ min_dfa << std::stoull(out[0]) << " " << dest << " " <<  char(label) << "\n"; }
-            edge_min++; 
-        }
+    D.origin = origin.data(); D.dest = dest.data(); D.label = label.data(); D.final_states = final_states.data();
+    prune_dfa(D,min_dfa_file,max_dfa_file,binary_out);
+}  
+   
+// prune a DFA of any size within the memory budget of cfg: the transitions are
+// streamed from the input and sorted by destination in external memory
+void prune_dfa_external(std::string input_file, std::string min_dfa_file, std::string max_dfa_file, bool binary_out,
+                        const ext_config& cfg)
+{
+    pruned_writer min_dfa(min_dfa_file,binary_out,cfg), max_dfa(max_dfa_file,binary_out,cfg);
+    dfa_header h;
+    prune_dfa_external(input_file,cfg,h,
+        [&](uint s){ min_dfa.final_state(s); max_dfa.final_state(s); },
+        [&](bool max, uint origin, uint code, uint dest){ (max ? max_dfa : min_dfa).add(origin,dest,char(code-1)); });
 
-        if( vmax[dest] == label )
-        { 
-            if( label <= 36 )
-            {
-                max_dfa << std::stoull(out[0]) << " " << dest << " " <<  char(label+36) << "\n";
-            }
-            else{ max_dfa << std::stoull(out[0]) << " " << dest << " " <<  char(label) << "\n"; }
-            edge_max++;
-        }
-        
+    #ifdef VERBOSE
+    {
+        std::cout << "Nodes: " << h.nodes << "\n";
+        std::cout << "Edges: " << h.edges << "\n";
+        std::cout << "Source: " << h.source << "\n";
+        std::cout << "No. acc. states: " << h.accepting << "\n";
     }
+    #endif
 
-    min_dfa << nodes << " " <<  edge_min << " " << source << " " << accepting << "\n";
-    max_dfa << nodes << " " <<  edge_max << " " << source << " " << accepting << "\n";
+    min_dfa.close(h.nodes,h.source);
+    max_dfa.close(h.nodes,h.source);
+}
 
-    min_dfa.close();
-    max_dfa.close();
+void print_help( void )
+{
+    std::cerr << "Format your command as follows: ./prune.x [options] input.dfa out.min out.max\n";
+    std::cerr << " -b         : write the pruned graphs in the binary format\n";
+    std::cerr << " -M [MB]    : external memory mode within the given memory budget\n";
+    std::cerr << " -T [dir]   : directory of the temporary files (def. $TMPDIR or /tmp)\n";
+}
 
-    // close stream to input file
-    input.close();
-}  
-   
 int main(int argc, char** argv)
 {
     // read command line arguments
-    std::string out_file_min, out_file_max, in_file;
-    // read input from file
-    if(argc > 3)
+    int opt;
+    bool binary_out = false, external = false;
+    size_t budget = 0;
+    std::string tmp_dir;
+    while( ( opt = getopt( argc, argv, "bM:T:" ) ) != -1 )
+    {
+        switch( opt )
+        {
+            case 'b': binary_out = true; break;
+            case 'M': external = true; budget = std::stoull(optarg) << 20; break;
+            case 'T': tmp_dir = std::string(optarg); break;
+            default: print_help(); exit(1);
+        }
+    }
+    // read input from file, text or binary
+    if(argc - optind > 2)
     { 
         // set input parameters
-        in_file = std::string(argv[1]);
-        out_file_min = std::string(argv[2]);
-        out_file_max = std::string(argv[3]);
-
-        prune_dfa(in_file, out_file_min, out_file_max); 
+        std::string in_file = std::string(argv[optind]);
+        std::string out_file_min = std::string(argv[optind+1]);
+        std::string out_file_max = std::string(argv[optind+2]);
 
+        if( external ){ prune_dfa_external(in_file, out_file_min, out_file_max, binary_out, ext_config(tmp_dir,budget)); }
+        else if( is_binary(in_file) ){ prune_dfa_binary(in_file, out_file_min, out_file_max, binary_out); }
+        else{ prune_dfa(in_file, out_file_min, out_file_max, binary_out); }
     }
     else
     {
         std::cerr << "invalid no. arguments\n";
-        std::cerr << "Format your command as follows: ./prune.x input.dfa out.min out.max\n";
+        print_help();
         exit(1);
     }
 
   return 0;
-}
\ No newline at end of file
+}
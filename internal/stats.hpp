@@ -0,0 +1,119 @@
+#ifndef STATS_HPP_
+#define STATS_HPP_
+
+#include <fstream>
+#include <sstream>
+#include <sys/resource.h>
+#include "automaton.hpp"
+#include "utils.hpp"
+
+/*
+    lightweight instrumentation of a run: wall time, peak RSS and counters of
+    named phases, written as one JSON object. The peak RSS of a phase is the
+    high-water mark of the process during the phase; it is reset at the start
+    of every phase through /proc/self/clear_refs where the kernel allows it, and
+    is the peak since the start of the process otherwise.
+*/
+class run_stats
+{
+public:
+    run_stats(std::string tool_) : tool(tool_){}
+
+    // start a phase (of the check of p, 0 if none), closing the current one
+    void begin(std::string name, uint p = 0)
+    {
+        end();
+        phases.push_back(phase());
+        phases.back().name = name;
+        phases.back().p = p;
+        std::ofstream clear("/proc/self/clear_refs");
+        if( clear ){ clear << "5"; }
+        sw.reset();
+        open = true;
+    }
+
+    // close the current phase
+    void end()
+    {
+        if( !open ){ return; }
+        phases.back().time = sw.elapsed();
+        phases.back().peak_rss = peak_rss();
+        open = false;
+    }
+
+    // counter of the current (or last) phase
+    template <typename T>
+    void count(std::string name, T x)
+    {
+        if( phases.empty() ){ return; }
+        std::ostringstream v;
+        v << x;
+        phases.back().counters.push_back({name,v.str()});
+    }
+
+    // field of the run (e.g. the answer)
+    template <typename T>
+    void set(std::string name, T x)
+    {
+        std::ostringstream v;
+        v << x;
+        fields.push_back({name,v.str()});
+    }
+
+    // close the current phase and write the JSON object to file
+    void write(std::string file)
+    {
+        end();
+        std::ofstream out(file);
+        out << "{\"tool\":\"" << tool << "\"";
+        for(auto& f: fields){ out << ",\"" << f.first << "\":" << f.second; }
+        out << ",\"time\":" << total.elapsed();
+        // the peak of the run is the largest one of the phases, since the resets also
+        // affect the peak reported by getrusage
+        uint64_t peak = peak_rss();
+        for(auto& ph: phases){ peak = std::max(peak,ph.peak_rss); }
+        out << ",\"peak_rss_kb\":" << peak << ",\"phases\":[";
+        for(size_t i=0;i<phases.size();++i)
+        {
+            auto& ph = phases[i];
+            out << (i > 0 ? "," : "") << "{\"name\":\"" << ph.name << "\"";
+            if( ph.p > 0 ){ out << ",\"p\":" << ph.p; }
+            out << ",\"time\":" << ph.time << ",\"peak_rss_kb\":" << ph.peak_rss;
+            for(auto& c: ph.counters){ out << ",\"" << c.first << "\":" << c.second; }
+            out << "}";
+        }
+        out << "]}\n";
+        out.close();
+    }
+
+private:
+    // high-water mark of the resident set size in kB
+    static uint64_t peak_rss()
+    {
+        std::ifstream status("/proc/self/status");
+        std::string key;
+        uint64_t kb;
+        while( status >> key )
+            if( key == "VmHWM:" && status >> kb ){ return kb; }
+        struct rusage u;
+        getrusage(RUSAGE_SELF,&u);
+        return static_cast<uint64_t>(u.ru_maxrss);
+    }
+
+    struct phase
+    {
+        std::string name;
+        uint p = 0;
+        double time = 0;
+        uint64_t peak_rss = 0;
+        std::vector< std::pair<std::string,std::string> > counters;
+    };
+
+    std::string tool;
+    std::vector< std::pair<std::string,std::string> > fields;
+    std::vector<phase> phases;
+    stopwatch sw, total;
+    bool open = false;
+};
+
+#endif
@@ -0,0 +1,140 @@
+#ifndef TEXT_READER_HPP_
+#define TEXT_READER_HPP_
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/*
+    buffered parser for the text formats: the input is read in chunks of 1MB and
+    integers are scanned by hand. scan_uint and scan_char skip any whitespace,
+    like operator>> on a stream; read_line parses the fields of one line and read
+    copies raw bytes.
+    Only depends on the standard library, so that the external tools can use it.
+*/
+class text_reader
+{
+public:
+    // read from file, or from the standard input if file is "-"
+    text_reader(std::string file) : buf(1 << 20)
+    {
+        owned = (file != "-");
+        f = owned ? std::fopen(file.c_str(),"rb") : stdin;
+    }
+    // read from an open stream (e.g. a pipe), closed on destruction if owned
+    text_reader(std::FILE* f_, bool owned_) : f(f_), owned(owned_), buf(1 << 20){}
+    ~text_reader(){ if( owned && f != nullptr ){ std::fclose(f); } }
+    text_reader(const text_reader&) = delete;
+    text_reader& operator=(const text_reader&) = delete;
+
+    bool is_open() const { return f != nullptr; }
+
+    // next character without consuming it, EOF at the end of the input
+    int peek()
+    {
+        if( pos == len && !fill() ){ return EOF; }
+        return static_cast<unsigned char>(buf[pos]);
+    }
+    int get()
+    {
+        int c = peek();
+        if( c != EOF ){ pos++; }
+        return c;
+    }
+
+    // skip whitespace and read an unsigned integer; false at the end of the input
+    // or if the next token does not start with a digit
+    bool scan_uint(uint64_t& x)
+    {
+        int c = skip(true);
+        if( c < '0' || c > '9' ){ return false; }
+        x = 0;
+        while( (c = peek()) >= '0' && c <= '9' ){ x = 10*x + (c-'0'); pos++; }
+        return true;
+    }
+
+    // skip whitespace and read one character; false at the end of the input
+    bool scan_char(char& a)
+    {
+        int c = skip(true);
+        if( c == EOF ){ return false; }
+        a = char(c); pos++;
+        return true;
+    }
+
+    // copy the next n bytes to dst, for binary inputs; returns the bytes copied
+    size_t read(void* dst, size_t n)
+    {
+        char* d = static_cast<char*>(dst);
+        size_t done = 0;
+        while( done < n && peek() != EOF )
+        {
+            size_t k = std::min(n-done,len-pos);
+            std::copy(buf.begin()+pos,buf.begin()+pos+k,d+done);
+            pos += k; done += k;
+        }
+        return done;
+    }
+
+    /*
+        parse the line at the current position and move to the next one. Every
+        field (token separated by spaces, tabs or \r) is stored in x, up to max
+        fields, as the value of its leading digits (0 if it has none), and its
+        first character in first, if given; returns the number of fields in the
+        line, 0 for an empty line, and U_EOF at the end of the input. numeric()
+        tells whether all the fields were unsigned integers.
+    */
+    static const size_t U_EOF = SIZE_MAX;
+    size_t read_line(uint64_t* x, size_t max, char* first = nullptr)
+    {
+        digits = true;
+        if( peek() == EOF ){ return U_EOF; }
+        size_t fields = 0;
+        int c;
+        while( (c = skip(false)) != EOF && c != '\n' )
+        {
+            if( first != nullptr && fields < max ){ first[fields] = char(c); }
+            if( c < '0' || c > '9' ){ digits = false; }
+            uint64_t v = 0;
+            while( (c = peek()) >= '0' && c <= '9' ){ v = 10*v + (c-'0'); pos++; }
+            while( (c = peek()) != EOF && !blank(c) && c != '\n' ){ pos++; digits = false; }
+            if( fields < max ){ x[fields] = v; }
+            fields++;
+        }
+        if( c == '\n' ){ pos++; }
+        return fields;
+    }
+
+    // true if every field of the last line parsed by read_line is an unsigned integer
+    bool numeric() const { return digits; }
+
+private:
+    static bool blank(int c){ return c == ' ' || c == '\t' || c == '\r'; }
+
+    // skip blanks, and newlines if newline is set; returns the next character
+    int skip(bool newline)
+    {
+        int c;
+        while( (c = peek()) != EOF && (blank(c) || (newline && c == '\n')) ){ pos++; }
+        return c;
+    }
+
+    bool fill()
+    {
+        if( f == nullptr ){ return false; }
+        len = std::fread(buf.data(),1,buf.size(),f);
+        pos = 0;
+        return len > 0;
+    }
+
+    std::FILE* f;
+    bool owned;
+    std::vector<char> buf;
+    size_t pos = 0, len = 0;
+    // all the fields of the last line are digits
+    bool digits = true;
+};
+
+#endif
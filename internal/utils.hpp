@@ -1,7 +1,12 @@
 #ifndef UTILS_HPP_
 #define UTILS_HPP_
 
+#include <chrono>
 #include "automaton.hpp"
+// binary file format
+#include "binary.hpp"
+// buffered text parser
+#include "text_reader.hpp"
 
 // DFA type
 //typedef DFA_unidirectional_out_labelled DFA;
@@ -20,43 +25,35 @@ U read_uint(std::string str)
     return static_cast<U>(std::stoull(str));
 }
 
-void tokenize(std::string const &str, const char delim, 
-            std::vector<std::string> &out) 
-{ 
-    // construct a stream from the string 
-    std::stringstream ss(str); 
-
-    // clear out vector
-    out.clear();
-    
-    // segment str using delim
-    std::string s; 
-    while (std::getline(ss, s, delim)) { 
-        out.push_back(s); 
-    } 
-}
-
 // simple parser for intermediate file; it reads line by line origin \t destination \t label \n
+// (or a binary intervals file, see binary.hpp)
 uint read_interval(std::string input_file, std::vector< std::pair <uint,uint> >& intervals,
                    bool remove_inf_eq_sup = false)
 {
-    // open stream to input
-    std::ifstream input(input_file);
-    std::string line;
-    const char delim = '\t'; 
-    uint beg, end;
-    uint max_beg = 0;
-    std::vector<std::string> out; 
-
-    while(true)
+    if( is_binary(input_file) )
     {
-        std::getline(input, line);
-        tokenize(line, delim, out);
+        mapped_file f(input_file);
+        interval_view v = map_interval(f,input_file);
+        uint max_beg = 0;
+        intervals.reserve(intervals.size()+v.states);
+        for(size_t i=0;i<v.states;++i)
+        {
+            uint beg = v.iv[2*i], end = v.iv[2*i+1];
+            if( remove_inf_eq_sup && (beg == end) ){ beg = end = 0; }
+            max_beg = std::max(max_beg,beg);
+            intervals.push_back(std::make_pair(beg,end));
+        }
+        return max_beg;
+    }
 
-        if(out.size() != 2){ break; };
+    text_reader input(input_file);
+    uint64_t x[2];
+    uint max_beg = 0;
 
-        beg = read_uint<uint>(out[0]);
-        end = read_uint<uint>(out[1]);
+    // read lines beg \t end up to the first line with a different number of fields
+    while( input.read_line(x,2) == 2 )
+    {
+        uint beg = static_cast<uint>(x[0]), end = static_cast<uint>(x[1]);
 
         if( remove_inf_eq_sup && (beg == end) )
         {
@@ -68,47 +65,171 @@ uint read_interval(std::string input_file, std::vector< std::pair <uint,uint> >&
         intervals.push_back(std::make_pair(beg,end));
     }
 
-    // close stream to input file
-    input.close();  
     // return maximum beginning value
     return max_beg;
 }  
 
 // simple parser for intermediate file; it reads line by line origin \t destination \t label \n
-template <typename DFA>
-void read_min_dfa(std::string input_file, DFA &A)
+// (or a binary DFA file, see binary.hpp). If source is given, it receives the source state
+void read_min_dfa(std::string input_file, min_dfa &A, uint* source = nullptr)
 {
-    // open stream to input
-    std::ifstream input(input_file);
-    std::string line;
-    const char delim = ' '; 
-    std::vector<std::string> out; 
-
-    // remove first line
-    uint origin, dest, label;
-    //int label;  
-    std::getline(input, line);
-    tokenize(line, delim, out);
-    A = DFA(read_uint<uint>(out[0]));
+    // binary file: build the transition table from the mapped arrays
+    if( is_binary(input_file) )
+    {
+        mapped_file f(input_file);
+        dfa_view v = map_dfa(f,input_file);
+        if( source != nullptr ){ *source = static_cast<uint>(v.source); }
+        A = min_dfa(static_cast<uint>(v.nodes),v.edges,[&](size_t i){ return transition{v.origin[i],char(v.label[i]),v.dest[i]}; });
+        return;
+    }
+
+    text_reader input(input_file);
+    uint64_t x[4];
+    DFA_edge_list D;
+
+    // the first line starts with the number of states
+    input.read_line(x,4);
+    D.nodes = static_cast<uint>(x[0]);
+    if( source != nullptr ){ *source = static_cast<uint>(x[2]); }
     
     // read all edges
-    while(true)
+    while( input.read_line(x,3) == 3 )
+        D.add_edge(static_cast<uint>(x[0]),char(x[1]),static_cast<uint>(x[2]));
+
+    A = min_dfa(D);
+}
+
+// parser for a DFA in the text format: the first line contains nodes edges source accepting,
+// followed by one edge per line (origin label destination) and one accepting state per line,
+// all unsigned integers; false if the input is not a DFA
+bool read_dfa(text_reader& input, DFA_edge_list &D)
+{
+    uint64_t x[4];
+
+    if( input.read_line(x,4) != 4 || !input.numeric() ){ return false; }
+
+    D = DFA_edge_list();
+    D.nodes = static_cast<uint>(x[0]);
+    uint edges = static_cast<uint>(x[1]);
+    D.source = static_cast<uint>(x[2]);
+    uint accepting = static_cast<uint>(x[3]);
+
+    // read all edges
+    D.edges.reserve(edges);
+    for(uint i=0;i<edges;++i)
+    {
+        if( input.read_line(x,3) != 3 || !input.numeric() ){ return false; }
+
+        D.add_edge(static_cast<uint>(x[0]),char(x[1]),static_cast<uint>(x[2]));
+    }
+    // read accepting states
+    D.accepting.reserve(accepting);
+    for(uint i=0;i<accepting;++i)
+    {
+        if( input.read_line(x,1) != 1 || !input.numeric() ){ return false; }
+        D.accepting.push_back(static_cast<uint>(x[0]));
+    }
+    return true;
+}
+
+// parser for a DFA file, text (see above) or binary (see binary.hpp)
+void read_dfa(std::string input_file, DFA_edge_list &D)
+{
+    if( is_binary(input_file) )
     {
-        std::getline(input, line);
-        tokenize(line, delim, out);
+        mapped_file f(input_file);
+        load_dfa_view(map_dfa(f,input_file),D);
+        return;
+    }
 
-        if(out.size() != 3){ break; };
+    text_reader input(input_file);
+    if( !read_dfa(input,D) )
+    {
+        std::cerr << "invalid DFA in " << input_file << "\n";
+        exit(1);
+    }
+}
 
-        origin = read_uint<uint>(out[0]);
-        label = read_uint<uint>(out[1]);
-        dest = read_uint<uint>(out[2]);
+// header of a DFA file
+struct dfa_header
+{
+    uint64_t nodes = 0, edges = 0, source = 0, accepting = 0;
+};
 
-        A.at(origin)->out.insert({label,dest});
+/*
+    read a DFA file (text or binary) in one sequential pass without storing it:
+    h receives the header, edge(origin,label,dest) is called for every
+    transition and final_state(s) for every accepting state
+*/
+template <typename Edge, typename Final>
+void scan_dfa(std::string input_file, dfa_header& h, Edge edge, Final final_state)
+{
+    if( is_binary(input_file) )
+    {
+        mapped_file f(input_file);
+        dfa_view v = map_dfa(f,input_file);
+        h.nodes = v.nodes; h.edges = v.edges; h.source = v.source; h.accepting = v.accepting;
+        for(size_t i=0;i<v.edges;++i){ edge(uint(v.origin[i]),char(v.label[i]),uint(v.dest[i])); }
+        for(size_t i=0;i<v.accepting;++i){ final_state(uint(v.final_states[i])); }
+        return;
     }
 
-    // close stream to input file
-    input.close();
-} 
+    text_reader input(input_file);
+    uint64_t x[4];
+    auto invalid = [&](const char* what)
+    {
+        std::cerr << "invalid DFA " << what << " in " << input_file << "\n";
+        exit(1);
+    };
+    if( input.read_line(x,4) != 4 || !input.numeric() ){ invalid("header"); }
+    h.nodes = x[0]; h.edges = x[1]; h.source = x[2]; h.accepting = x[3];
+    for(size_t i=0;i<h.edges;++i)
+    {
+        if( input.read_line(x,3) != 3 || !input.numeric() ){ invalid("edge"); }
+        edge(uint(x[0]),char(x[1]),uint(x[2]));
+    }
+    for(size_t i=0;i<h.accepting;++i)
+    {
+        if( input.read_line(x,1) != 1 || !input.numeric() ){ invalid("accepting state"); }
+        final_state(uint(x[0]));
+    }
+}
+
+// write a DFA in the format read by read_dfa
+void write_dfa(std::string output_file, const DFA_edge_list &D)
+{
+    std::ofstream output(output_file);
+    output << D.nodes << " " << D.edges.size() << " " << D.source << " " << D.accepting.size() << "\n";
+    for(auto& e: D.edges)
+        output << e.origin << " " << uint(static_cast<unsigned char>(e.label)) << " " << e.dest << "\n";
+    for(auto& f: D.accepting)
+        output << f << "\n";
+    output.close();
+}
+
+// write the intervals in the format read by read_interval
+void write_interval(std::string output_file, const std::vector< std::pair <uint,uint> >& intervals)
+{
+    std::ofstream output(output_file);
+    for(auto& i: intervals)
+        output << i.first << "\t" << i.second << "\n";
+    output.close();
+}
+
+// wall clock timer
+class stopwatch
+{
+public:
+    stopwatch(){ reset(); }
+    void reset(){ t0 = std::chrono::steady_clock::now(); }
+    // seconds since the last reset
+    double elapsed() const
+    {
+        return std::chrono::duration<double>(std::chrono::steady_clock::now()-t0).count();
+    }
+private:
+    std::chrono::steady_clock::time_point t0;
+};
 
 void counting_sort(std::vector< std::pair <uint,uint> > &vec, std::vector<uint> &out, uint m)
 {
@@ -0,0 +1,1518 @@
+#ifndef WIDTH_HPP_
+#define WIDTH_HPP_
+
+#include <algorithm>
+#include <array>
+#include <functional>
+#include <type_traits>
+#include "automaton.hpp"
+#include "utils.hpp"
+// iterative cycle detection
+#include "cycle.hpp"
+// thread pool helpers
+#include "parallel.hpp"
+// run instrumentation
+#include "stats.hpp"
+
+typedef DFA_unidirectional_out_labelled<tuple_set> DFA; // DFA type
+
+// buffer for a tuple of P states, on the stack; P = 0: p states on the heap
+template <uint P>
+struct tuple_buffer
+{
+    tuple_buffer(uint){}
+    uint& operator[](uint i){ return t[i]; }
+    uint* data(){ return t.data(); }
+    std::array<uint,P> t;
+};
+
+template <>
+struct tuple_buffer<0>
+{
+    tuple_buffer(uint p) : t(p){}
+    uint& operator[](uint i){ return t[i]; }
+    uint* data(){ return t.data(); }
+    std::vector<uint> t;
+};
+
+/*
+    A^p pruned automaton construction and cyclicity check. The minimum DFA, the
+    intervals and the L data structure (states with the same outgoing label, sorted
+    by interval beginning) are computed once and shared by all tested values of p.
+
+    A cycle of A^p projects on every component onto a closed walk of the minimum
+    DFA, so all the transitions it follows stay inside the strongly connected
+    components of their states. The L lists therefore only keep the state s in
+    the list of label a if the transition of s on a stays in its component: the
+    states on no cycle of the minimum DFA drop out of all lists, the others out
+    of the lists of the labels leaving their component. The tuples of a cycle of
+    A^p share one of the labels kept, so they are still enumerated, with the
+    labels of their edges on the cycle; on a nearly acyclic DFA most tuples are
+    never generated.
+*/
+class width_checker
+{
+public:
+
+    // rs_, if given, records the phases of the construction and of the checks
+    width_checker(min_dfa& M_, std::vector< std::pair<uint,uint> >& intervals_, run_stats* rs_ = nullptr)
+        : M(M_), intervals(intervals_), rs(rs_)
+    {
+        uint n = static_cast<uint>(intervals.size());
+        uint max_beg = 0;
+        for(auto& i: intervals)
+            if( i.first > max_beg ){ max_beg = i.first; }
+
+        #ifdef VERBOSE
+        {
+            std::cout << "### sorting intervals ###\n";
+            std::cout << "-> number of intervals: " << n << "\n";
+        }
+        #endif
+
+        // sort the intervals and store their ordering in order
+        begin_phase("counting_sort");
+        std::vector<uint> order(n);
+        counting_sort(intervals, order, max_beg+1);
+
+        #ifdef VERBOSE
+        {
+            // print intervals
+            for(uint i=0;i<intervals.size();++i)
+            {
+                std::cout << intervals[order[i]].first << " - " << intervals[order[i]].second << " : " << order[i] << "\n";
+            }
+        }
+        #endif
+
+        // strongly connected components of the minimum DFA
+        begin_phase("scc");
+        uint sccs = scc_ids(M.no_states(),
+            [&](uint u){ return M.last(u)-M.first(u); },
+            [&](uint u, uint k){ return M.dest_at(M.first(u)+k); }, scc);
+        if( rs != nullptr )
+        {
+            uint cyclic = 0;
+            for(uint i=0;i<M.no_states();++i)
+                if( on_cycle(i) ){ cyclic++; }
+            rs->count("sccs",sccs);
+            rs->count("cyclic_states",cyclic);
+        }
+
+        // create L data structure, without the transitions leaving their component;
+        // the instrumentation keeps the full lists to count the tuples removed
+        begin_phase("L");
+        size_t acyclic_entries = 0, exit_entries = 0;
+        for(uint x=0;x<n;++x)
+        {
+            uint i = order[x];
+            bool cyclic = on_cycle(i);
+            for (uint e=M.first(i);e<M.last(i);++e)
+            {
+                char a = M.label_at(e);
+                if( rs != nullptr ){ L_all[a].push_back(i); }
+                if( !internal(i,e) )
+                {
+                    (cyclic ? exit_entries : acyclic_entries)++;
+                    continue;
+                }
+                if(L.find(a) != L.end())
+                {
+                    L[a].push_back(i);
+                }
+                else{ L[a] = std::vector<uint>{ i }; }
+            }
+        }
+
+        // overlap depth of each list: A^p has no state with label j if depth[j] < p
+        for (auto& j: L)
+            depth[j.first] = overlap_depth(j.second);
+        build_label_masks();
+        if( rs != nullptr )
+        {
+            size_t entries = 0;
+            for (auto& j: L){ entries += j.second.size(); }
+            rs->count("lists",L.size());
+            rs->count("entries",entries);
+            rs->count("acyclic_entries",acyclic_entries);
+            rs->count("exit_entries",exit_entries);
+            rs->end();
+        }
+
+        #ifdef VERBOSE
+        {
+            std::cout << "-> " << sccs << " strongly connected components, " << acyclic_entries
+                      << " L entries of acyclic states and " << exit_entries << " leaving their component removed\n";
+            std::cout << "-> L data structure\n";
+            // print L data structure
+            for (auto& j: L)
+            {
+                std::cout << j.first << " : ";
+                for(uint i=0;i<j.second.size();++i)
+                {
+                    std::cout << j.second[i] << " ";
+                }
+                std::cout << std::endl;
+            }
+        }
+        #endif
+    }
+
+    // number of states in the minimum DFA
+    uint no_states(){ return static_cast<uint>(intervals.size()); }
+
+    // number of threads building the states and the edges of A^p (def. 1)
+    void set_threads(uint threads_){ threads = std::max(threads_,1u); }
+
+    // cycle detection algorithm used by find_cycle and find_cycle_sim
+    void set_cycle_algorithm(cycle_algorithm algo_){ algo = algo_; }
+
+    // statistics of the last p check or exact width probe
+    struct check_stats
+    {
+        // wall time of the stages, in seconds
+        double states_time = 0, edges_time = 0, cycle_time = 0;
+        // states of A^p (visited ones in the on-the-fly mode) and edges (full mode)
+        uint states = 0;
+        size_t edges = 0;
+    };
+    const check_stats& stats(){ return last; }
+
+    // keep a cycle of A^p found by the p checks, see witness()
+    void set_witness(bool witness_){ want_witness = witness_; }
+
+    // states of the minimum DFA forming the cycle found by the last p check: the
+    // tuples of the A^p states along the cycle, p states each
+    const std::vector<uint>& witness(){ return cycle_tuples; }
+
+    // print the witness cycle as a sequence of tuples, closed by its first tuple
+    void print_witness(std::ostream& out)
+    {
+        if( cycle_tuples.empty() ){ return; }
+        out << "witness cycle:";
+        for(size_t k=0;k<=cycle_tuples.size();k+=p)
+        {
+            size_t b = k % cycle_tuples.size();
+            out << (k > 0 ? " -> (" : " (");
+            for(uint i=0;i<p;++i){ out << (i > 0 ? " " : "") << cycle_tuples[b+i]; }
+            out << ")";
+        }
+        out << "\n";
+    }
+
+    // write the witness cycle for a certificate: p and its number of tuples, then
+    // one tuple per line; is_cycle checks it
+    void write_witness(std::ostream& out)
+    {
+        out << "cycle " << p << " " << (cycle_tuples.size()/std::max<uint>(p,1)) << "\n";
+        for(size_t k=0;k<cycle_tuples.size();k+=p)
+        {
+            for(uint i=0;i<p;++i){ out << (i > 0 ? " " : "") << cycle_tuples[k+i]; }
+            out << "\n";
+        }
+    }
+
+    /*
+        certificate of width < p: the states of A^p in a topological order, every
+        edge leading from a tuple to a later one. Writes "order p n", then the n
+        tuples one per line, and returns true; returns false, writing nothing, if
+        A^p has a cycle. A checker enumerates the states of A^p from the intervals
+        and the L lists (p overlapping states sharing a label whose transition
+        stays in their components), checks that they are the tuples written, and
+        that the successor of every tuple on every label is not an earlier one.
+    */
+    bool write_order(std::ostream& out, uint p_)
+    {
+        build_states_sim(p_);
+        begin_phase("order");
+        explored = 0;
+        std::vector<uint> order;
+        bool cyclic = false;
+        with_width([&](auto P)
+        {
+            std::vector<uint> t(p);
+            cyclic = kahn_cycle(mapping.size(),
+                [&](uint){ return static_cast<uint>(alph.size()); },
+                [&](uint u, uint k){ return successor<P>(mapping.at(u),alph[k],t.data()); },
+                explored, nullptr, &order);
+        });
+        end_cycle_phase(cyclic);
+        if( !cyclic )
+        {
+            out << "order " << p << " " << order.size() << "\n";
+            for(auto u: order)
+            {
+                for(uint i=0;i<p;++i){ out << (i > 0 ? " " : "") << mapping.at(u)[i]; }
+                out << "\n";
+            }
+        }
+        mapping.clear();
+        return !cyclic;
+    }
+
+    // build the A^p pruned automaton and check whether it contains a cycle
+    bool find_cycle(uint p_)
+    {
+        build_automaton(p_);
+        begin_phase("cycle");
+        stopwatch sw;
+        explored = 0;
+        std::vector<uint> cycle;
+        bool cyclic = ::find_cycle(algo,threads,G.no_nodes(),
+            [&](uint u){ return static_cast<uint>(G.off[u+1]-G.off[u]); },
+            [&](uint u, uint k){ return G.adj[G.off[u]+k]; }, explored,
+            want_witness ? &cycle : nullptr);
+        last.cycle_time = sw.elapsed();
+        end_cycle_phase(cyclic);
+        report_cycle_detection(algorithm_name(),cyclic,G.no_nodes());
+        keep_witness(cycle,*A.give_mapping());
+        A.clear();
+        G.clear();
+        return cyclic;
+    }
+
+    // compute the states of the A^p pruned automaton and check whether it contains
+    // a cycle by simulating its edges on the minimum DFA (reduced memory)
+    bool find_cycle_sim(uint p_)
+    {
+        build_states_sim(p_);
+        begin_phase("cycle");
+        stopwatch sw;
+        explored = 0;
+        std::vector<uint> cycle;
+        bool cyclic = false;
+        with_width([&](auto P)
+        {
+            cyclic = ::find_cycle(algo,threads,mapping.size(),
+                [&](uint){ return static_cast<uint>(alph.size()); },
+                [&](uint u, uint k)
+                {
+                    // the parallel algorithm calls the successor function concurrently
+                    thread_local std::vector<uint> t;
+                    t.resize(p);
+                    return successor<P>(mapping.at(u),alph[k],t.data());
+                }, explored, want_witness ? &cycle : nullptr);
+        });
+        last.cycle_time = sw.elapsed();
+        end_cycle_phase(cyclic);
+        report_cycle_detection(algorithm_name(),cyclic,mapping.size());
+        keep_witness(cycle,mapping);
+        mapping.clear();
+        return cyclic;
+    }
+
+    /*
+        Wheeler test: check whether A^2 contains a cycle on the pair graph. Its
+        states are the overlapping pairs of every L list, stored as packed keys in
+        a pair_set; the edges are not stored: the successors of {u,v} follow the
+        transitions of u whose label also leaves v, so the labels of the states
+        are not needed either. Faster than both A^2 constructions and smaller than
+        the full one.
+    */
+    bool find_cycle_pairs()
+    {
+        // the packed keys need 32-bit states
+        if( sizeof(uint) > 4 ){ return find_cycle(2); }
+        build_pairs();
+        begin_phase("cycle");
+        stopwatch sw;
+        explored = 0;
+        std::vector<uint> cycle;
+        bool cyclic = ::find_cycle(algo,threads,pairs.size(),
+            [&](uint u){ return pair_slots(u); },
+            [&](uint u, uint k){ return pair_successor(u,k); },
+            explored, want_witness ? &cycle : nullptr);
+        last.cycle_time = sw.elapsed();
+        end_cycle_phase(cyclic);
+        report_cycle_detection(algorithm_name(),cyclic,pairs.size());
+        cycle_tuples.clear();
+        for(auto u: cycle)
+        {
+            cycle_tuples.push_back(pair_set::first(pairs.key(u)));
+            cycle_tuples.push_back(pair_set::second(pairs.key(u)));
+        }
+        pairs.clear();
+        return cyclic;
+    }
+
+    /*
+        on-the-fly check: the states of A^p enumerated from L are used as roots of a
+        DFS that generates the successors on the minimum DFA; only the visited
+        tuples and the current path are stored and the visit stops at the first
+        cycle, so a positive answer usually touches a small part of A^p.
+    */
+    bool find_cycle_lazy(uint p_)
+    {
+        p = p_;
+        sim = false;
+        lazy = true;
+        found = false;
+        explored = 0;
+        cycle_tuples.clear();
+        last = check_stats();
+        reset_counters();
+        begin_phase("lazy_cycle");
+        stopwatch sw;
+        visited.reset(p);
+        on_path.clear();
+        alph.clear();
+        for (auto& j: L)
+            if( j.second.size() >= p && depth[j.first] >= p )
+                alph.push_back(j.first);
+        std::sort(alph.begin(),alph.end());
+
+        #ifdef VERBOSE
+            std::cout << "### on-the-fly A^" << p << " cycle detection ###\n";
+        #endif
+
+        construct_states();
+        last.cycle_time = sw.elapsed();
+        last.states = visited.size();
+        if( rs != nullptr )
+        {
+            // the roots are the tuples enumerated from L, the visited states include their successors
+            rs->count("roots",tuples);
+            rs->count("visited",visited.size());
+            rs->count("rehashes",visited.rehashes());
+            count_scc_pruning();
+            end_cycle_phase(found);
+        }
+        report_cycle_detection("on-the-fly DFS",found,0);
+
+        // the enumeration of the other checks stops on found: reset it
+        bool cyclic = found;
+        lazy = found = false;
+        visited.clear();
+        on_path.clear();
+        on_path.shrink_to_fit();
+        return cyclic;
+    }
+
+    /*
+        true if tuples, a sequence of tuples of p states, is a cycle of A^p: every
+        tuple is a state and a label leads from each tuple to the next one and
+        from the last to the first. It checks a witness, e.g. one found on a
+        previous version of the DFA, without building A^p.
+    */
+    bool is_cycle(const std::vector<uint>& tuples, uint p_)
+    {
+        p = p_;
+        size_t k = (p > 0) ? tuples.size()/p : 0;
+        if( k == 0 || tuples.size() % p != 0 ){ return false; }
+        std::vector<uint> s(tuples);
+        for(size_t i=0;i<k;++i)
+        {
+            uint* t = &s[i*p];
+            for(uint j=0;j<p;++j)
+                if( t[j] >= no_states() ){ return false; }
+            if( !tuple_set::sort_tuple(t,p) || !is_state(t) ){ return false; }
+        }
+        std::vector<uint> t(p);
+        for(size_t i=0;i<k;++i)
+        {
+            const uint* u = &s[i*p];
+            const uint* v = &s[((i+1)%k)*p];
+            bool edge = false;
+            for (uint e=M.first(u[0]);e<M.last(u[0]) && !edge;++e)
+                edge = M.next_all(u,M.label_at(e),t.data(),p) && tuple_set::sort_tuple(t.data(),p) &&
+                       std::equal(t.begin(),t.end(),v);
+            if( !edge ){ return false; }
+        }
+        return true;
+    }
+
+    /*
+        number of tuples enumerated from L for p, i.e. of p-cliques of overlapping
+        intervals with a common label: an upper bound on the states of A^p, found
+        by the sweep of the lists without enumerating the tuples
+    */
+    size_t tuple_count(uint p_)
+    {
+        p = p_;
+        return estimate_tuples();
+    }
+
+    /*
+        exact width: doubling followed by binary search on p. All probes share L;
+        a p-cycle proves width >= p and every (p+1)-cycle of A^(p+1) projects onto
+        p-cycles, so after a successful probe L keeps only the states lying on a
+        cycle of A^p. The overlap depth of the lists bounds the width from above.
+        Known bounds lo_ <= width <= hi_ (e.g. from a result cache) skip probes.
+        The restriction is local to the search: the lists are restored before
+        returning, so the checker can be reused for any p. With set_witness, the
+        witness is a cycle of A^width (width >= 2), found on the restricted lists.
+    */
+    uint exact_width(bool sim_, uint lo_ = 1, uint hi_ = U_MAX)
+    {
+        uint lo = std::max<uint>(lo_,1), hi = std::min({no_states(),max_depth(),hi_});
+        cycle_tuples.clear();
+        auto saved_L = L, saved_all = L_all;
+        auto saved_depth = depth;
+        uint q = 2;
+        while( q <= lo ){ q *= 2; }
+
+        while( lo < hi && q <= hi )
+        {
+            if( !probe(q,sim_) ){ hi = q-1; break; }
+            lo = q;
+            hi = std::min(hi,max_depth());
+            q *= 2;
+        }
+        while( lo < hi )
+        {
+            q = lo + (hi-lo+1)/2;
+            if( probe(q,sim_) )
+            {
+                lo = q;
+                hi = std::min(hi,max_depth());
+            }
+            else{ hi = q-1; }
+        }
+        // on the restricted lists the on-the-fly check stops quickly
+        if( want_witness && lo >= 2 ){ find_cycle_lazy(lo); }
+
+        L.swap(saved_L);
+        L_all.swap(saved_all);
+        depth.swap(saved_depth);
+        build_label_masks();
+        // the probes keep the memory of A^p for the next one
+        A.clear();
+        G.clear();
+        mapping.clear();
+        pairs.clear();
+        return lo;
+    }
+
+private:
+
+    // build the A^p pruned automaton: states and edges
+    void build_automaton(uint p_)
+    {
+        p = p_;
+        sim = false;
+        A.reset(p);
+        last = check_stats();
+        reset_counters();
+        begin_phase("ap_states");
+        stopwatch sw;
+        size_t est = reserve_tuples();
+        A.reserve(static_cast<uint>(std::min(est,reserve_cap)),std::min(est,reserve_cap));
+
+        #ifdef VERBOSE
+        {
+            std::cout << "### compute A^" << p << " pruned automaton ###\n";
+            std::cout << "-> States in the A^" << p << " pruned automaton\n";
+        }
+        #endif
+
+        // construct the A^p pruned automaton
+        construct_states();
+        last.states_time = sw.elapsed();
+        last.states = A.no_nodes();
+        count_tuples(*A.give_mapping());
+        begin_phase("ap_edges");
+        sw.reset();
+
+        #ifdef VERBOSE
+        {
+            for (uint m=0;m<A.no_nodes();++m)
+            {
+                std::cout << m << ": (";
+                print_tuple(A.give_mapping()->at(m));
+                std::cout << ") labels: (";
+                bool first = true;
+                for (auto j: A.labels(m))
+                {
+                    if( !first ){ std::cout << " "; }
+                    std::cout << j;
+                    first = false;
+                }
+                std::cout << ")\n";
+            }
+            std::cout << "Number of states: " << A.no_nodes() << "\n";
+            std::cout << "-> Edges in the A^" << p <<" pruned automaton\n";
+        }
+        #endif
+
+        // compute edges in the A^p squared automaton
+        with_width([&](auto P){ construct_edges<P>(); });
+        last.edges_time = sw.elapsed();
+        last.edges = G.no_edges();
+        if( rs != nullptr )
+        {
+            rs->count("edges",G.no_edges());
+            rs->count("pruned_successors",pruned_successors);
+            rs->end();
+        }
+
+        // check if the A^p automaton has cycles
+        #ifdef VERBOSE
+        {
+            std::cout << "Number of edges: " << G.no_edges() << "\n";
+            std::cout << "### check A^" << p << " automaton cyclicity ###\n";
+        }
+        #endif
+    }
+
+    // compute the edges of A^p; nodes are visited in order, so the successor
+    // lists are written directly in CSR form
+    template <uint P>
+    void construct_edges()
+    {
+        G.reset();
+        if( threads > 1 ){ construct_edges_parallel<P>(); return; }
+        G.off.reserve(size_t(A.no_nodes())+1);
+        successors<P>(0,A.no_nodes(),[&](uint m, char j, uint entry)
+        {
+            #ifdef VERBOSE
+                std::cout << "(";
+                print_tuple(A.give_mapping()->at(m));
+                std::cout << ") ->(" << j << ") (";
+                print_tuple(A.give_mapping()->at(entry));
+                std::cout << ")\n";
+            #else
+                (void)m; (void)j;
+            #endif
+            // add an edge if the reached state has at least
+            // one outgoing edge.
+            G.adj.push_back(entry);
+        },[&](uint){ G.end_node(); },pruned_successors);
+    }
+
+    /*
+        successors of the states [beg,end) of A^p on their labels, in batches of
+        edge_batch states: the successor tuples of a batch are computed on the
+        minimum DFA and sorted, and the table slots where their searches start are
+        prefetched before the searches run, so that their cache misses overlap.
+        emit(m,label,id) is called for every successor that is a state, in order,
+        and done(m) after the successors of state m; the others are counted in
+        pruned. Only reads the tuple set, so ranges can run concurrently
+    */
+    template <uint P, typename Emit, typename Done>
+    void successors(uint beg, uint end, Emit emit, Done done, size_t& pruned)
+    {
+        tuple_set* T = A.give_mapping();
+        const uint w = P ? P : p;
+        // successor tuples of the batch, their labels and home slots (SIZE_MAX: not a
+        // tuple of distinct states), and the number of labels of every state
+        std::vector<uint> buf;
+        std::vector<char> lab;
+        std::vector<size_t> home;
+        std::vector<uint> labels;
+        for(uint b=beg;b<end;b+=edge_batch)
+        {
+            uint e = std::min(end,b+edge_batch);
+            buf.clear(); lab.clear(); home.clear(); labels.clear();
+            for(uint m=b;m<e;++m)
+            {
+                const uint* source = T->at(m);
+                uint k = 0;
+                for (auto j: A.labels(m))
+                {
+                    buf.resize(buf.size()+w);
+                    uint* t = &buf[buf.size()-w];
+                    size_t h = SIZE_MAX;
+                    if( M.next_all<P>(source,j,t,p) && tuple_set::sort_tuple<P>(t,p) )
+                    {
+                        h = T->home<P>(t);
+                        T->prefetch(h);
+                    }
+                    lab.push_back(j);
+                    home.push_back(h);
+                    k++;
+                }
+                labels.push_back(k);
+            }
+            size_t x = 0;
+            for(uint m=b;m<e;++m)
+            {
+                for(uint k=0;k<labels[m-b];++k,++x)
+                {
+                    uint entry = (home[x] != SIZE_MAX) ? T->find<P>(&buf[x*w],home[x]) : U_MAX;
+                    if( entry == U_MAX ){ pruned++; }
+                    else{ emit(m,lab[x],entry); }
+                }
+                done(m);
+            }
+        }
+    }
+
+    // compute the CSR edges of A^p on ranges of nodes in parallel; the tuple set
+    // is only read, through the searches of successors
+    template <uint P>
+    void construct_edges_parallel()
+    {
+        uint n = A.no_nodes();
+        size_t chunk = std::max<size_t>(1024,n/(4*threads)+1);
+        size_t ranges = (n+chunk-1)/chunk;
+        std::vector< std::vector<uint> > adj(ranges);
+        std::vector<size_t> pruned(ranges,0);
+        G.off.resize(size_t(n)+1);
+
+        parallel_for(threads,ranges,[&](size_t r)
+        {
+            size_t d = 0;
+            successors<P>(static_cast<uint>(r*chunk),static_cast<uint>(std::min<size_t>(n,(r+1)*chunk)),
+                [&](uint, char, uint entry){ adj[r].push_back(entry); ++d; },
+                [&](uint m){ G.off[m+1] = d; d = 0; },pruned[r]);
+        });
+
+        for(auto x: pruned){ pruned_successors += x; }
+        for(uint m=0;m<n;++m){ G.off[m+1] += G.off[m]; }
+        G.adj.reserve(G.off[n]);
+        for(auto& a: adj)
+        {
+            G.adj.insert(G.adj.end(),a.begin(),a.end());
+            std::vector<uint>().swap(a);
+        }
+    }
+
+    // compute the states of the A^p pruned automaton and its alphabet (reduced memory)
+    void build_states_sim(uint p_)
+    {
+        p = p_;
+        sim = true;
+        mapping.reset(p);
+        freq.assign(256,0);
+        alph.clear();
+        last = check_stats();
+        reset_counters();
+        begin_phase("ap_states");
+        stopwatch sw;
+
+        #ifdef VERBOSE
+        {
+            std::cout << "### compute A^" << p << " pruned automaton ###\n";
+            std::cout << "-> States in the A^" << p << " pruned automaton\n";
+        }
+        #endif
+
+        // construct the A^p pruned automaton
+        construct_states();
+
+        // find alphabet
+        for(uint i=0;i<256;++i)
+            if(freq[i] > 0)
+                alph.push_back(char(i));
+        // clear frequency vector
+        freq.clear();
+        last.states_time = sw.elapsed();
+        last.states = mapping.size();
+        if( rs != nullptr )
+        {
+            count_tuples(mapping);
+            rs->end();
+        }
+
+        #ifdef VERBOSE
+        {
+            for (uint m=0;m<mapping.size();++m)
+            {
+                std::cout << m << ": (";
+                print_tuple(mapping.at(m));
+                std::cout << ")\n";
+            }
+            std::cout << "Number of states: " << mapping.size() << "\n";
+            std::cout << "Alphabet size: " << alph.size() << "\n";
+        }
+        #endif
+    }
+
+    // compute the states of the pair graph (A^2) from the L lists
+    void build_pairs()
+    {
+        p = 2;
+        sim = false;
+        last = check_stats();
+        reset_counters();
+        begin_phase("ap_states");
+        stopwatch sw;
+        pairs.clear();
+
+        #ifdef VERBOSE
+            std::cout << "### compute the pair graph (A^2) ###\n";
+        #endif
+
+        for (auto& j: L)
+        {
+            const std::vector<uint>& v = j.second;
+            if( v.size() < 2 || depth[j.first] < 2 ){ pruned_lists++; continue; }
+            // labels before j.first: a pair sharing one of them is generated by its list
+            uint64_t before = label_mask.empty() ? 0 : label_bit(j.first)-1;
+            // the states following v[i] in the list and beginning before its end
+            for(size_t i=0;i+1<v.size();++i)
+            {
+                uint end = intervals[v[i]].second;
+                for(size_t k=i+1;k<v.size() && intervals[v[k]].first < end;++k)
+                {
+                    tuples++;
+                    if( before != 0 && (label_mask[v[i]] & label_mask[v[k]] & before) != 0 ){ continue; }
+                    pairs.insert(pair_set::pack(v[i],v[k]));
+                }
+            }
+        }
+        last.states_time = sw.elapsed();
+        last.states = pairs.size();
+        count_tuples(pairs);
+        if( rs != nullptr ){ rs->end(); }
+
+        #ifdef VERBOSE
+            std::cout << "Number of states: " << pairs.size() << "\n";
+            std::cout << "### check A^2 automaton cyclicity ###\n";
+        #endif
+    }
+
+    // pair graph: successor slots of pair u, one for every transition of its first state
+    uint pair_slots(uint u)
+    {
+        uint a = pair_set::first(pairs.key(u));
+        return M.last(a)-M.first(a);
+    }
+
+    // pair graph: successor of pair u on the k-th transition of its first state,
+    // U_MAX if the second state has no transition with that label or the reached
+    // pair is not a state
+    uint pair_successor(uint u, uint k)
+    {
+        uint64_t x = pairs.key(u);
+        uint e = M.first(pair_set::first(x))+k;
+        uint a = M.dest_at(e), b = M.next(pair_set::second(x),M.label_at(e));
+        if( b == U_MAX || a == b ){ return U_MAX; }
+        return pairs.find(pair_set::pack(a,b));
+    }
+
+    // exact width probe: check whether A^p contains a cycle and, if so, restrict
+    // L to the states of the minimum DFA lying on a cycle of A^p (until exact_width
+    // restores it)
+    bool probe(uint p_, bool sim_)
+    {
+        std::vector<bool> cyclic;
+        tuple_set* T = nullptr;
+
+        if( p_ == 2 && !sim_ && sizeof(uint) == 4 )
+        {
+            build_pairs();
+            begin_phase("cycle");
+            cyclic = cyclic_nodes(pairs.size(),
+                [&](uint u){ return pair_slots(u); },
+                [&](uint u, uint k){ return pair_successor(u,k); });
+        }
+        else if( !sim_ )
+        {
+            build_automaton(p_);
+            begin_phase("cycle");
+            cyclic = cyclic_nodes(G.no_nodes(),
+                [&](uint u){ return static_cast<uint>(G.off[u+1]-G.off[u]); },
+                [&](uint u, uint k){ return G.adj[G.off[u]+k]; });
+            T = A.give_mapping();
+        }
+        else
+        {
+            build_states_sim(p_);
+            begin_phase("cycle");
+            T = &mapping;
+            with_width([&](auto P)
+            {
+                cyclic = cyclic_nodes(mapping.size(),
+                    [&](uint){ return static_cast<uint>(alph.size()); },
+                    [&](uint u, uint k){ return successor<P>(mapping.at(u),alph[k]); });
+            });
+        }
+
+        // states of the minimum DFA lying on a cycle of A^p
+        std::vector<bool> alive(no_states(),false);
+        bool found = false;
+        for(uint u=0;u<cyclic.size();++u)
+        {
+            if( !cyclic[u] ){ continue; }
+            found = true;
+            if( T == nullptr )
+            {
+                alive[pair_set::first(pairs.key(u))] = true;
+                alive[pair_set::second(pairs.key(u))] = true;
+                continue;
+            }
+            const uint* t = T->at(u);
+            for (uint i=0;i<p;++i)
+                alive[t[i]] = true;
+        }
+
+        end_cycle_phase(found,false);
+
+        #ifdef VERBOSE
+            std::cout << "-> exact width probe p = " << p << ": " << (found ? "cycle" : "no cycle") << "\n";
+        #endif
+
+        // restrict the L lists
+        if( found )
+        {
+            for (auto& j: L)
+            {
+                uint k = 0;
+                for(uint i=0;i<j.second.size();++i)
+                    if( alive[j.second[i]] ){ j.second[k++] = j.second[i]; }
+                j.second.resize(k);
+                depth[j.first] = overlap_depth(j.second);
+            }
+            for (auto& j: L_all)
+                j.second.erase(std::remove_if(j.second.begin(),j.second.end(),[&](uint s){ return !alive[s]; }),j.second.end());
+            build_label_masks();
+        }
+
+        return found;
+    }
+
+    // sweep the list sorted by beginning: f(i,d) is called for every index i, where
+    // d is the number of intervals up to the i-th one containing its beginning
+    template <typename F>
+    void overlap_sweep(const std::vector<uint>& list, F f)
+    {
+        std::vector<uint> ends;
+        for(uint i=0;i<list.size();++i)
+        {
+            // intervals ending before the current beginning are closed
+            ends.push_back(intervals[list[i]].second);
+            std::push_heap(ends.begin(),ends.end(),std::greater<uint>());
+            while( !ends.empty() && ends.front() <= intervals[list[i]].first )
+            {
+                std::pop_heap(ends.begin(),ends.end(),std::greater<uint>());
+                ends.pop_back();
+            }
+            f(i,static_cast<uint>(ends.size()));
+        }
+    }
+
+    // maximum number of pairwise overlapping intervals in a list sorted by beginning
+    uint overlap_depth(const std::vector<uint>& list)
+    {
+        uint d = 0;
+        overlap_sweep(list,[&](uint, uint a){ d = std::max(d,a); });
+        return d;
+    }
+
+    /*
+        number of tuples enumerated from L for the current p: the i-th state of a
+        list closes the tuples made of p-1 of the a_i previous states overlapping
+        it, C(a_i,p-1) of them. It bounds the number of states of A^p and is the
+        number of their labels, so it sizes the arenas before the construction.
+    */
+    size_t estimate_tuples()
+    {
+        double total = 0;
+        for (auto& j: L)
+            if( j.second.size() >= p && depth[j.first] >= p ){ total += list_tuples(j.second); }
+        return total >= 1e18 ? size_t(1e18) : static_cast<size_t>(total+0.5);
+    }
+
+    // number of tuples enumerated from the list for the current p
+    double list_tuples(const std::vector<uint>& list)
+    {
+        double total = 0;
+        overlap_sweep(list,[&](uint i, uint a)
+        {
+            // previous intervals overlapping the i-th one
+            auto& v = intervals[list[i]];
+            if( v.second > v.first ){ a--; }
+            double c = 1;
+            for(uint k=1;k<p && c > 0;++k){ c = c*(double(a)-k+1)/k; }
+            total += c;
+        });
+        return total;
+    }
+
+    // tuples of the full L lists removed for the current p by the two rules of the
+    // component pruning: those with an acyclic state and those with a state whose
+    // transition on the label leaves its component
+    void count_scc_pruning()
+    {
+        if( rs == nullptr ){ return; }
+        double all = 0, cyclic = 0, kept = 0;
+        std::vector<uint> v;
+        for (auto& j: L_all)
+        {
+            all += list_tuples(j.second);
+            v.clear();
+            for(auto s: j.second)
+                if( on_cycle(s) ){ v.push_back(s); }
+            cyclic += list_tuples(v);
+        }
+        for (auto& j: L){ kept += list_tuples(j.second); }
+        rs->count("scc_acyclic_tuples",static_cast<size_t>(std::max(all-cyclic,0.0)+0.5));
+        rs->count("scc_exit_tuples",static_cast<size_t>(std::max(cyclic-kept,0.0)+0.5));
+    }
+
+    // estimate the tuples of A^p, recording the estimate in the statistics
+    size_t reserve_tuples()
+    {
+        size_t est = estimate_tuples();
+        if( rs != nullptr ){ rs->count("estimated_tuples",est); }
+        return est;
+    }
+
+    // maximum overlap depth over all L lists
+    uint max_depth()
+    {
+        uint d = 0;
+        for (auto& j: depth)
+            d = std::max(d,j.second);
+        return d;
+    }
+
+    /*
+        run f(std::integral_constant<uint,P>()) with P = p if the kernels are
+        specialized for p (2 <= p <= 8), P = 0 (generic kernels) otherwise
+    */
+    template <typename F>
+    void with_width(F f)
+    {
+        switch( p )
+        {
+            case 2: f(std::integral_constant<uint,2>()); break;
+            case 3: f(std::integral_constant<uint,3>()); break;
+            case 4: f(std::integral_constant<uint,4>()); break;
+            case 5: f(std::integral_constant<uint,5>()); break;
+            case 6: f(std::integral_constant<uint,6>()); break;
+            case 7: f(std::integral_constant<uint,7>()); break;
+            case 8: f(std::integral_constant<uint,8>()); break;
+            default: f(std::integral_constant<uint,0>());
+        }
+    }
+
+    // enumerate the states of A^p generated by every label list in L
+    void construct_states()
+    {
+        with_width([&](auto P){ construct_states<P>(); });
+    }
+
+    template <uint P>
+    void construct_states()
+    {
+        if( threads > 1 && !lazy ){ construct_states_parallel<P>(); return; }
+
+        tuple_buffer<P> t(p);
+        for (auto& j: L)
+        {
+            if( j.second.size() < p || depth[j.first] < p ){ pruned_lists++; continue; }
+            char label = j.first;
+            auto emit = [&](const uint* s){ add_tuple<P>(s,label); };
+            enumerate_list<P>(j.second,0,j.second.size(),t.data(),emit);
+            if( found ){ break; }
+        }
+    }
+
+    /*
+        sweep over the list v, sorted by interval beginning: when the i-th state is
+        reached the active set holds the previous states whose interval contains
+        its beginning, in list order, so every tuple of p-1 active states followed
+        by v[i] is a tuple of p overlapping states and every such tuple is emitted
+        exactly once, when its last state is reached. The states with index in
+        [beg,end) close the tuples; the active set of beg is found by a scan. The
+        cost is the number of tuples plus O(p) per state, instead of rescanning the
+        list at every level for states that cannot complete a tuple.
+    */
+    template <uint P, typename Emit>
+    void enumerate_list(const std::vector<uint>& v, size_t beg, size_t end, uint* t, Emit& emit)
+    {
+        const uint w = P ? P : p;
+        std::vector<uint> active;
+        if( beg < end )
+            for(size_t j=0;j<beg;++j)
+                if( intervals[v[j]].second > intervals[v[beg]].first ){ active.push_back(v[j]); }
+        for(size_t i=beg;i<end && !found;++i)
+        {
+            // drop the intervals ending before the current beginning
+            uint b = intervals[v[i]].first;
+            size_t k = 0;
+            for(auto x: active)
+                if( intervals[x].second > b ){ active[k++] = x; }
+            active.resize(k);
+            if( active.size()+1 >= w )
+            {
+                t[w-1] = v[i];
+                if( P > 0 ){ choose_tuples<P,0>(active,0,t,emit); }
+                else{ choose_tuples(active,0,0,t,emit); }
+            }
+            active.push_back(v[i]);
+        }
+    }
+
+    // t[l..p-2] takes every subset of the states of s with index >= beg, in
+    // order, and emit(t) is called on every resulting tuple
+    template <typename Emit>
+    void choose_tuples(const std::vector<uint>& s, uint l, size_t beg, uint* t, Emit& emit)
+    {
+        if( l+1 == p ){ emit(t); return; }
+        // leave room for the states of the next levels
+        for(size_t i=beg;i+(p-1-l)<=s.size() && !found;++i)
+        {
+            t[l] = s[i];
+            choose_tuples(s,l+1,i+1,t,emit);
+        }
+    }
+
+    // as above for a width P known at compile time: the level l is a template
+    // argument, so the p-1 nested loops are unrolled
+    template <uint P, uint l, typename Emit>
+    void choose_tuples(const std::vector<uint>& s, size_t beg, uint* t, Emit& emit)
+    {
+        if constexpr( P > 0 && l+1 == P ){ emit(t); }
+        else if constexpr( P > 0 )
+        {
+            for(size_t i=beg;i+(P-1-l)<=s.size() && !found;++i)
+            {
+                t[l] = s[i];
+                choose_tuples<P,l+1>(s,i+1,t,emit);
+            }
+        }
+    }
+
+    // add the tuple s generated by label to the pruned automaton
+    template <uint P>
+    void add_tuple(const uint* s, char label)
+    {
+        const uint w = P ? P : p;
+        tuples++;
+        uint64_t others = 0;
+        if( !generates<P>(s,label,others) ){ return; }
+        if( lazy )
+        {
+            // start a visit from the state
+            std::copy(s,s+w,visited.scratch());
+            visited.normalize<P>();
+            found = lazy_visit();
+        }
+        else if( !sim )
+        {
+            std::copy(s,s+w,A.give_mapping()->scratch());
+            A.give_mapping()->normalize<P>();
+            uint id = A.add_state<P>(label);
+            for_each_label(others,[&](char c){ A.add_label(id,c); });
+        }
+        else
+        {
+            // every label generating a state belongs to the alphabet of A^p
+            freq[uint(static_cast<unsigned char>(label))]++;
+            for_each_label(others,[&](char c){ freq[uint(static_cast<unsigned char>(c))]++; });
+            std::copy(s,s+w,mapping.scratch());
+            mapping.normalize<P>();
+            mapping.insert<P>();
+        }
+    }
+
+    /*
+        parallel construction of the states: the sweep of every L list is split in
+        tasks by the last state of the tuples, and every task sorts its tuples into
+        shards by hash. Each shard is then deduplicated by one thread and the shards
+        are numbered in order, so the state ids do not depend on the scheduling.
+    */
+    template <uint P>
+    void construct_states_parallel()
+    {
+        struct task { char label; const std::vector<uint>* v; size_t beg, end; };
+        std::vector<task> tasks;
+        for (auto& j: L)
+        {
+            if( j.second.size() < p || depth[j.first] < p ){ pruned_lists++; continue; }
+            // ranges of the last state of the tuples
+            size_t n = j.second.size();
+            size_t chunk = std::max<size_t>(1,(n-(p-1))/(4*threads));
+            for(size_t b=p-1;b<n;b+=chunk)
+                tasks.push_back({j.first,&j.second,b,std::min(n,b+chunk)});
+        }
+
+        // generated tuples (sorted) and their labels, by task and shard
+        const uint w = P ? P : p;
+        uint shards = threads;
+        std::vector< std::vector< std::vector<uint> > > tup(tasks.size(),std::vector< std::vector<uint> >(shards));
+        std::vector< std::vector< std::vector<char> > > lab(tasks.size(),std::vector< std::vector<char> >(shards));
+        // tuples left to the list of their first shared label, by task
+        std::vector<size_t> skipped(tasks.size(),0);
+        parallel_for(threads,tasks.size(),[&](size_t k)
+        {
+            tuple_buffer<P> t(p), t_(p);
+            auto emit = [&](const uint* s)
+            {
+                uint64_t others;
+                if( !generates<P>(s,tasks[k].label,others) ){ skipped[k]++; return; }
+                std::copy(s,s+w,t_.data());
+                tuple_set::sort_tuple<P>(t_.data(),p);
+                uint h = shard<P>(t_.data(),shards);
+                tup[k][h].insert(tup[k][h].end(),t_.data(),t_.data()+w);
+                lab[k][h].push_back(tasks[k].label);
+            };
+            enumerate_list<P>(*tasks[k].v,tasks[k].beg,tasks[k].end,t.data(),emit);
+        });
+
+        // deduplicate every shard, recording the id in the shard and the label of
+        // every generated tuple, in generation order
+        std::vector<tuple_set> set(shards,tuple_set(p));
+        std::vector< std::vector<uint> > ids(shards);
+        std::vector< std::vector<char> > labels(shards);
+        for(size_t k=0;k<tasks.size();++k)
+        {
+            tuples += skipped[k];
+            for(uint h=0;h<shards;++h){ tuples += lab[k][h].size(); }
+        }
+        parallel_for(threads,shards,[&](size_t h)
+        {
+            for(size_t k=0;k<tasks.size();++k)
+            {
+                for(size_t r=0;r<lab[k][h].size();++r)
+                {
+                    std::copy(&tup[k][h][r*w],&tup[k][h][r*w]+w,set[h].scratch());
+                    ids[h].push_back(set[h].insert<P>().first);
+                    labels[h].push_back(lab[k][h][r]);
+                }
+                std::vector<uint>().swap(tup[k][h]);
+                std::vector<char>().swap(lab[k][h]);
+            }
+        });
+
+        // number the states shard by shard: the ids of a shard first occur in
+        // increasing order, so the state of a tuple is created at its first label
+        uint total = 0;
+        for(auto& h: set){ total += h.size(); }
+        tuple_set* T = sim ? &mapping : A.give_mapping();
+        T->reserve(total);
+        for(uint h=0;h<shards;++h)
+        {
+            uint base = T->size(), next = 0;
+            for(size_t r=0;r<ids[h].size();++r)
+            {
+                uint k = ids[h][r];
+                char c = labels[h][r];
+                if( sim ){ freq[uint(static_cast<unsigned char>(c))]++; }
+                if( k < next )
+                {
+                    if( !sim ){ A.add_label(base+k,c); }
+                    continue;
+                }
+                std::copy(set[h].at(k),set[h].at(k)+w,T->scratch());
+                // the other shared labels of the tuple, generated by c only
+                uint64_t others;
+                generates<P>(set[h].at(k),c,others);
+                if( !sim )
+                {
+                    uint id = A.add_state<P>(c);
+                    for_each_label(others,[&](char a){ A.add_label(id,a); });
+                }
+                else
+                {
+                    for_each_label(others,[&](char a){ freq[uint(static_cast<unsigned char>(a))]++; });
+                    mapping.insert<P>();
+                }
+                next++;
+            }
+            set[h].clear();
+            std::vector<uint>().swap(ids[h]);
+            std::vector<char>().swap(labels[h]);
+        }
+    }
+
+    /*
+        label masks: bit r of label_mask[s] is set if state s is in the L list of
+        the r-th label. A tuple of overlapping states is enumerated by the list of
+        every label its states share, so with the masks only the list of the first
+        shared label generates it, together with the others found by AND-ing the
+        masks of its states: every tuple is hashed once instead of once per label.
+        The masks are not built with more than 64 lists, and all lists generate.
+    */
+    void build_label_masks()
+    {
+        label_mask.clear();
+        if( L.size() > 64 ){ return; }
+        std::vector<char> labels;
+        for (auto& j: L){ labels.push_back(j.first); }
+        std::sort(labels.begin(),labels.end());
+        label_mask.assign(no_states(),0);
+        for(uint r=0;r<labels.size();++r)
+        {
+            rank_label[r] = labels[r];
+            label_rank[static_cast<unsigned char>(labels[r])] = r;
+            for(auto s: L[labels[r]]){ label_mask[s] |= uint64_t(1) << r; }
+        }
+    }
+
+    // mask bit of the list of label a
+    uint64_t label_bit(char a){ return uint64_t(1) << label_rank[static_cast<unsigned char>(a)]; }
+
+    // true if the list of label a generates the tuple t (see build_label_masks);
+    // others gets the other labels shared by its states
+    template <uint P>
+    bool generates(const uint* t, char a, uint64_t& others)
+    {
+        const uint w = P ? P : p;
+        others = 0;
+        if( label_mask.empty() ){ return true; }
+        uint64_t m = label_mask[t[0]];
+        for(uint i=1;i<w;++i){ m &= label_mask[t[i]]; }
+        uint64_t bit = label_bit(a);
+        if( (m & (bit-1)) != 0 ){ return false; }
+        others = m & ~bit;
+        return true;
+    }
+
+    // call f on the label of every bit of the mask m
+    template <typename F>
+    void for_each_label(uint64_t m, F f)
+    {
+        for(;m != 0;m &= m-1){ f(rank_label[__builtin_ctzll(m)]); }
+    }
+
+    // shard of the sorted tuple t
+    template <uint P>
+    uint shard(const uint* t, uint shards)
+    {
+        const uint w = P ? P : p;
+        size_t h = 0;
+        for(uint i=0;i<w;++i){ hash_combine(h,t[i]); }
+        // use the high bits: the low ones select the slot inside the shard
+        return static_cast<uint>(((h * 0x9E3779B97F4A7C15ull) >> 32) % shards);
+    }
+
+    // reduced memory mode: id of the successor of tuple s on label a, U_MAX if
+    // it is not a state of A^p
+    template <uint P>
+    uint successor(const uint* s, char a)
+    {
+        return successor<P>(s,a,mapping.scratch());
+    }
+
+    // as above, computing the successor in the buffer curr of p states instead of
+    // the scratch tuple of mapping
+    template <uint P>
+    uint successor(const uint* s, char a, uint* curr)
+    {
+        // skip if we map to an illegal state
+        if( !M.next_all<P>(s,a,curr,p) ){ return U_MAX; }
+        return tuple_set::sort_tuple<P>(curr,p) ? mapping.find<P>(curr) : U_MAX;
+    }
+
+    // copy the tuples of the cycle (ids in T) into cycle_tuples
+    void keep_witness(const std::vector<uint>& cycle, tuple_set& T)
+    {
+        cycle_tuples.clear();
+        for(auto u: cycle)
+            cycle_tuples.insert(cycle_tuples.end(),T.at(u),T.at(u)+p);
+    }
+
+    std::string algorithm_name()
+    {
+        switch( algo )
+        {
+            case KAHN_CYCLE: return "Kahn";
+            case PARALLEL_CYCLE: return "parallel Kahn";
+            default: return "DFS";
+        }
+    }
+
+    // on-the-fly mode: true if the tuple in the scratch slot of visited is a state
+    // of A^p
+    bool is_state()
+    {
+        return visited.normalize() && is_state(visited.scratch());
+    }
+
+    // true if the sorted tuple t of distinct states is a state of A^p, i.e. its
+    // states share an outgoing label kept in L (staying in their components) and
+    // overlap as tested by enumerate_list: in the L order (by interval beginning,
+    // then by state) the last state begins before every other state ends
+    bool is_state(const uint* t)
+    {
+        uint last = 0, end = U_MAX;
+        for(uint i=1;i<p;++i)
+            if( intervals[t[i]].first >= intervals[t[last]].first ){ last = i; }
+        for(uint i=0;i<p;++i)
+            if( i != last ){ end = std::min(end,intervals[t[i]].second); }
+        if( intervals[t[last]].first >= end ){ return false; }
+        for (uint e=M.first(t[0]);e<M.last(t[0]);++e)
+        {
+            if( !internal(t[0],e) ){ continue; }
+            uint i = 1;
+            for(;i < p;++i)
+            {
+                uint d = M.next(t[i],M.label_at(e));
+                if( d == U_MAX || scc[d] != scc[t[i]] ){ break; }
+            }
+            if( i == p ){ return true; }
+        }
+        return false;
+    }
+
+    // true if the transition e of state q stays in the component of q
+    bool internal(uint q, uint e){ return scc[M.dest_at(e)] == scc[q]; }
+
+    // true if the state q lies on a cycle of the minimum DFA
+    bool on_cycle(uint q)
+    {
+        for (uint e=M.first(q);e<M.last(q);++e)
+            if( internal(q,e) ){ return true; }
+        return false;
+    }
+
+    /*
+        on-the-fly mode: iterative DFS from the (sorted) scratch tuple of visited;
+        the path stack holds tuple ids and the position of the next label in alph.
+        Return true if a cycle is found.
+    */
+    bool lazy_visit()
+    {
+        auto root = visited.insert();
+        if( !root.second ){ return false; }
+        on_path.push_back(true);
+        explored++;
+        std::vector< std::pair<uint,uint> > path{{root.first,0}};
+
+        while( !path.empty() )
+        {
+            uint u = path.back().first;
+            if( path.back().second == alph.size() )
+            {
+                on_path[u] = false;
+                path.pop_back();
+                continue;
+            }
+            char a = alph[path.back().second++];
+
+            // successor on label a
+            if( !M.next_all(visited.at(u),a,visited.scratch(),p) || !is_state() ){ continue; }
+
+            uint w = visited.find();
+            if( w != U_MAX )
+            {
+                // back edge: cycle found
+                if( on_path[w] )
+                {
+                    if( want_witness )
+                    {
+                        size_t k = path.size()-1;
+                        while( path[k].first != w ){ --k; }
+                        std::vector<uint> cycle;
+                        for(;k<path.size();++k){ cycle.push_back(path[k].first); }
+                        keep_witness(cycle,visited);
+                    }
+                    return true;
+                }
+                continue;
+            }
+            w = visited.insert().first;
+            on_path.push_back(true);
+            explored++;
+            path.push_back({w,0});
+        }
+
+        return false;
+    }
+
+    #ifdef VERBOSE
+    void print_tuple(const uint* t)
+    {
+        for(uint i=0;i<p;++i)
+        {
+            if( i > 0 ){ std::cout << " "; }
+            std::cout << t[i];
+        }
+    }
+    #endif
+
+    // instrumentation: phases of the current p (see stats.hpp) and counters of the
+    // last A^p construction
+    void begin_phase(const char* name){ if( rs != nullptr ){ rs->begin(name,p); } }
+    void reset_counters(){ tuples = pruned_successors = 0; pruned_lists = 0; }
+    template <typename Set>
+    void count_tuples(Set& T)
+    {
+        if( rs == nullptr ){ return; }
+        count_scc_pruning();
+        rs->count("states",T.size());
+        rs->count("tuples",tuples);
+        rs->count("pruned_tuples",tuples-T.size());
+        rs->count("pruned_lists",pruned_lists);
+        rs->count("hash_slots",T.slots());
+        rs->count("hash_load",T.slots() > 0 ? double(T.size())/T.slots() : 0.0);
+        rs->count("rehashes",T.rehashes());
+    }
+    void end_cycle_phase(bool cyclic, bool visit = true)
+    {
+        if( rs == nullptr ){ return; }
+        if( visit ){ rs->count("explored",explored); }
+        rs->count("cyclic",cyclic ? "true" : "false");
+        rs->end();
+    }
+
+    // print the outcome of the cycle detection and the number of explored states
+    // out of V (V = 0: the number of states is not known)
+    void report_cycle_detection(std::string name, bool cyclic, uint V)
+    {
+        #ifdef VERBOSE
+            std::cout << "-> " << name << " cycle detection: "
+                      << (cyclic ? "cycle found" : "no cycle") << " after " << explored;
+            if( V > 0 ){ std::cout << " of " << V; }
+            std::cout << " states\n";
+        #else
+            (void)name; (void)cyclic; (void)V;
+        #endif
+    }
+
+    // minimum DFA
+    min_dfa& M;
+    // intervals vector
+    std::vector< std::pair<uint,uint> >& intervals;
+    // strongly connected component of every state of the minimum DFA
+    std::vector<uint> scc;
+    // states with the same outgoing label, staying in their component, sorted by
+    // interval beginning; with the instrumentation also the full lists
+    std::unordered_map<char,std::vector<uint>> L, L_all;
+    // maximum number of pairwise overlapping intervals in each L list
+    std::unordered_map<char,uint> depth;
+    // L lists of every state as a mask of label ranks (see build_label_masks)
+    std::vector<uint64_t> label_mask;
+    std::array<char,64> rank_label;
+    std::array<uint8_t,256> label_rank;
+    // tested width
+    uint p = 0;
+    // reduced memory (simulated edges) mode
+    bool sim = false;
+    // on-the-fly mode and its outcome, set only during find_cycle_lazy
+    bool lazy = false;
+    bool found = false;
+
+    // threads building A^p
+    uint threads = 1;
+
+    // cycle detection algorithm
+    cycle_algorithm algo = DFS_CYCLE;
+    // statistics of the last check
+    check_stats last;
+    // keep the cycle found by the p checks and its tuples
+    bool want_witness = false;
+    std::vector<uint> cycle_tuples;
+
+    // A^p pruned automaton: states and CSR edges. The probes of the exact width
+    // reuse their memory; at most reserve_cap tuples are reserved upfront
+    static constexpr size_t reserve_cap = size_t(1) << 24;
+    // states of A^p whose successors are searched in one batch
+    static constexpr uint edge_batch = 16;
+    DFA A;
+    csr_graph G;
+    // reduced memory mode: mapping between states and ids
+    DFA::mapt mapping;
+    // Wheeler test: states of the pair graph
+    pair_set pairs;
+    std::vector<uint> freq; // character frequencies
+    std::vector<char> alph; // aphabet vector
+    // on-the-fly mode: visited tuples and tuples on the DFS path
+    tuple_set visited;
+    std::vector<bool> on_path;
+    // states explored by the last cycle detection
+    uint explored = 0;
+
+    // instrumentation, if any: tuples enumerated from L (states before the
+    // deduplication), L lists skipped by the depth test and successors that are
+    // not states of A^p
+    run_stats* rs = nullptr;
+    size_t tuples = 0, pruned_successors = 0;
+    uint pruned_lists = 0;
+};
+
+#endif
@@ -0,0 +1,137 @@
+#ifndef WORKLOADS_HPP_
+#define WORKLOADS_HPP_
+
+#include <random>
+#include "automaton.hpp"
+
+/*
+    synthetic DFA families for benchmarking. Labels are small positive integers
+    (stored as char), the source is state 0 unless stated otherwise.
+*/
+
+/*
+    random nearly-acyclic DFA, as external/DFAgen-suffixdoubling/random-nearly-acyclic-dfa.cpp:
+    state v > 0 gets up to indeg transitions from random earlier states with fewer
+    than sigma outgoing transitions, then extra random transitions are added
+    (forward ones only unless backward is set). States without outgoing
+    transitions are accepting; labels are distinct per state, in [1,sigma].
+*/
+void random_nearly_acyclic(uint n, uint sigma, uint indeg, uint extra, bool backward, uint seed, DFA_edge_list& D)
+{
+    std::mt19937 rng(seed);
+    auto rand_range = [&](uint m){ return static_cast<uint>(rng() % m); };
+
+    std::vector<uint> available, outdegree(n,0);
+    std::vector< std::pair<uint,uint> > edges;
+    std::vector<bool> final_state(n,true);
+
+    for(uint v=0;v<n;++v)
+    {
+        uint d = std::min(indeg,v);
+        while( !available.empty() && d-- > 0 )
+        {
+            uint i = rand_range(available.size());
+            uint u = available[i];
+            edges.push_back({u,v});
+            final_state[u] = false;
+            if( ++outdegree[u] == sigma )
+            {
+                available[i] = available.back();
+                available.pop_back();
+            }
+        }
+        available.push_back(v);
+    }
+
+    while( !available.empty() && extra > 0 )
+    {
+        uint i = rand_range(available.size());
+        uint u = available[i], v;
+        if( !backward )
+        {
+            if( available.size() == 1 ){ break; }
+            if( u == n-1 ){ continue; }
+            v = u+1+rand_range(n-u-1);
+        }
+        else{ v = rand_range(n); }
+        edges.push_back({u,v});
+        if( ++outdegree[u] == sigma )
+        {
+            available[i] = available.back();
+            available.pop_back();
+        }
+        --extra;
+    }
+
+    // distinct random labels for the transitions of each state
+    std::sort(edges.begin(),edges.end());
+    std::vector<uint> alpha(sigma);
+    for(uint c=0;c<sigma;++c){ alpha[c] = c; }
+    D = DFA_edge_list();
+    D.nodes = n;
+    D.source = 0;
+    for(size_t i=0,k=0;i<edges.size();++i,++k)
+    {
+        if( i > 0 && edges[i-1].first != edges[i].first ){ k = 0; }
+        std::swap(alpha[k],alpha[k+rand_range(sigma-k)]);
+        D.add_edge(edges[i].first,char(alpha[k]+1),edges[i].second);
+    }
+    for(uint v=0;v<n;++v)
+        if( final_state[v] ){ D.accepting.push_back(v); }
+}
+
+/*
+    disjoint union of p cyclic chains of length len with width exactly p: the source
+    enters chain i with label i, every chain spells the cycle p+1,...,p+len and its
+    first state leaves with label p+len+i to the accepting state. States at the
+    same position of different chains are pairwise co-lex incomparable, the
+    others are comparable. Requires 2p+len < 256.
+*/
+void chains(uint p, uint len, DFA_edge_list& D)
+{
+    assert(2*p+len < 256);
+    D = DFA_edge_list();
+    D.nodes = p*len+2;
+    D.source = 0;
+    uint final_state = p*len+1;
+    for(uint i=0;i<p;++i)
+    {
+        uint first = 1+i*len;
+        D.add_edge(0,char(1+i),first);
+        for(uint k=0;k<len;++k)
+            D.add_edge(first+k,char(p+1+k),first+(k+1)%len);
+        D.add_edge(first,char(p+len+1+i),final_state);
+    }
+    D.accepting.push_back(final_state);
+}
+
+/*
+    concatenation of k copies of B: the accepting states of each copy move to the
+    source of the next one with a label not used by B; only the accepting
+    states of the last copy accept
+*/
+void scaled(const DFA_edge_list& B, uint k, DFA_edge_list& D)
+{
+    std::vector<bool> used(256,false);
+    for(auto& e: B.edges){ used[static_cast<unsigned char>(e.label)] = true; }
+    uint sep = 1;
+    while( sep < 256 && used[sep] ){ ++sep; }
+    assert(sep < 256);
+
+    D = DFA_edge_list();
+    D.nodes = B.nodes*k;
+    D.source = B.source;
+    for(uint c=0;c<k;++c)
+    {
+        uint offset = c*B.nodes;
+        for(auto& e: B.edges)
+            D.add_edge(offset+e.origin,e.label,offset+e.dest);
+        for(auto f: B.accepting)
+        {
+            if( c+1 < k ){ D.add_edge(offset+f,char(sep),offset+B.nodes+B.source); }
+            else{ D.accepting.push_back(offset+f); }
+        }
+    }
+}
+
+#endif